@@ -1,3 +1,7 @@
+// Keeps windows.h from defining min and max macros, which break std::min/std::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <windows.h>
 #include <cstdio>
 #include <cstring>
@@ -12,201 +16,67 @@
 #include <unordered_map>
 #include <mutex>
 #include <map>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <ctime>
 #include "json_utils.hpp"
+#include "volume_service.hpp"
+#include "file_types.hpp"
+#include "scan_breakdown.hpp"
+#include "scanner.hpp"
+#include "text_output.hpp"
+#include "vfs.hpp"
+#include "directory_listing.hpp"
+#include "directory_cache.hpp"
+#include "scan_progress.hpp"
 
-// Helper struct for folder stats
-struct FolderStats {
-    ULONGLONG size = 0;
-    int files = 0; // total files (recursive)
-};
-
-// Recursively compute folder stats (size and file count only)
-void GetFolderStatsRecursive(const std::string& folder, FolderStats& stats, std::atomic<bool>* cancel_flag = nullptr) {
-    if (cancel_flag && *cancel_flag) return;
-    char search_path[MAX_PATH];
-    snprintf(search_path, sizeof(search_path), "%s*", folder.c_str());
-    WIN32_FIND_DATAA find_data;
-    HANDLE hFind = FindFirstFileA(search_path, &find_data);
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (cancel_flag && *cancel_flag) break;
-            if (strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0)
-                continue;
-            bool is_dir = (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-            if (is_dir) {
-                std::string subfolder = folder + find_data.cFileName + "\\";
-                GetFolderStatsRecursive(subfolder, stats, cancel_flag);
-            } else {
-                stats.files++;
-                LARGE_INTEGER fsize;
-                fsize.HighPart = find_data.nFileSizeHigh;
-                fsize.LowPart = find_data.nFileSizeLow;
-                stats.size += fsize.QuadPart;
-            }
-        } while (FindNextFileA(hFind, &find_data));
-        FindClose(hFind);
+// Draws the capacity bar (or probe state) of a volume on the current line
+void DrawVolumeUsage(const VolumeInfo& volume) {
+    ImGui::SameLine();
+    if (volume.state == VolumeState::Unresponsive) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.3f, 1.0f), "not responding");
+        return;
+    }
+    if (volume.state == VolumeState::Pending) {
+        ImGui::TextDisabled("probing...");
+        return;
+    }
+    if (volume.state == VolumeState::Error || volume.total_bytes == 0) {
+        ImGui::TextDisabled("unavailable");
+        return;
+    }
+    char free_str[32], total_str[32], overlay[96];
+    FormatByteSize(volume.free_bytes, free_str, sizeof(free_str));
+    FormatByteSize(volume.total_bytes, total_str, sizeof(total_str));
+    snprintf(overlay, sizeof(overlay), "%s free", free_str);
+    float used = 1.0f - (float)((double)volume.free_bytes / (double)volume.total_bytes);
+    // Turn the bar red once the volume is more than 90% full
+    if (used > 0.9f) ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.85f, 0.2f, 0.2f, 1.0f));
+    ImGui::ProgressBar(used, ImVec2(-FLT_MIN, ImGui::GetTextLineHeight()), overlay);
+    if (used > 0.9f) ImGui::PopStyleColor();
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("%s\nType: %s\nDevice: %s\nFree: %s of %s (%.1f%% used)", volume.root.c_str(),
+            volume.fs_type.empty() ? "unknown" : volume.fs_type.c_str(),
+            volume.device.empty() ? "-" : volume.device.c_str(), free_str, total_str, used * 100.0f);
     }
 }
 
-// --- File type mapping function ---
-std::string GetFileTypeName(const std::string& ext) {
-    static const std::map<std::string, std::string> type_map = {
-        {"pdf", "Portable Document Format"},
-        {"swf", "Shockwave Flash Format"},
-        {"txt", "Text Document"},
-        {"doc", "Microsoft Word Document"},
-        {"docx", "Microsoft Word Document"},
-        {"xls", "Microsoft Excel Spreadsheet"},
-        {"xlsx", "Microsoft Excel Spreadsheet"},
-        {"ppt", "Microsoft PowerPoint Presentation"},
-        {"pptx", "Microsoft PowerPoint Presentation"},
-        {"jpg", "JPEG Image"},
-        {"jpeg", "JPEG Image"},
-        {"png", "Portable Network Graphics"},
-        {"gif", "Graphics Interchange Format"},
-        {"bmp", "Bitmap Image"},
-        {"tiff", "Tagged Image File Format"},
-        {"svg", "Scalable Vector Graphics"},
-        {"mp3", "MP3 Audio"},
-        {"wav", "Waveform Audio"},
-        {"ogg", "Ogg Vorbis Audio"},
-        {"flac", "FLAC Audio"},
-        {"mp4", "MPEG-4 Video"},
-        {"avi", "AVI Video"},
-        {"mov", "QuickTime Movie"},
-        {"wmv", "Windows Media Video"},
-        {"mkv", "Matroska Video"},
-        {"zip", "ZIP Archive"},
-        {"rar", "RAR Archive"},
-        {"7z", "7-Zip Archive"},
-        {"tar", "TAR Archive"},
-        {"gz", "GZIP Archive"},
-        {"exe", "Windows Executable"},
-        {"dll", "Dynamic Link Library"},
-        {"bat", "Batch File"},
-        {"cmd", "Command Script"},
-        {"cpp", "C++ Source File"},
-        {"h", "C/C++ Header File"},
-        {"c", "C Source File"},
-        {"js", "JavaScript File"},
-        {"json", "JSON File"},
-        {"xml", "XML File"},
-        {"html", "HTML Document"},
-        {"htm", "HTML Document"},
-        {"css", "Cascading Style Sheet"},
-        {"py", "Python Script"},
-        {"java", "Java Source File"},
-        {"php", "PHP Script"},
-        {"rb", "Ruby Script"},
-        {"go", "Go Source File"},
-        {"sh", "Shell Script"},
-        {"md", "Markdown Document"},
-        {"ini", "Configuration File"},
-        {"log", "Log File"},
-        {"iso", "ISO Disk Image"},
-        {"apk", "Android Package"},
-        {"db", "Database File"},
-        {"sqlite", "SQLite Database"},
-        {"csv", "Comma-Separated Values"},
-        {"tsv", "Tab-Separated Values"},
-        {"yml", "YAML File"},
-        {"yaml", "YAML File"},
-        {"psd", "Photoshop Document"},
-        {"ai", "Adobe Illustrator File"},
-        {"eps", "Encapsulated PostScript"},
-        {"rtf", "Rich Text Format"},
-        {"odt", "OpenDocument Text"},
-        {"ods", "OpenDocument Spreadsheet"},
-        {"odp", "OpenDocument Presentation"},
-        {"apk", "Android Package"},
-        {"bat", "Batch File"},
-        {"com", "DOS Command File"},
-        {"msi", "Windows Installer Package"},
-        {"sys", "System File"},
-        {"tmp", "Temporary File"},
-        {"bak", "Backup File"},
-        {"torrent", "BitTorrent File"},
-        {"eml", "Email Message"},
-        {"msg", "Outlook Mail Message"},
-        {"ics", "iCalendar File"},
-        {"vcf", "vCard File"},
-        {"dat", "Data File"},
-        {"bin", "Binary File"},
-        {"apk", "Android Package"},
-        {"app", "Application Bundle"},
-        {"dmg", "Apple Disk Image"},
-        {"pkg", "Package File"},
-        {"deb", "Debian Package"},
-        {"rpm", "Red Hat Package"},
-        {"vbs", "VBScript File"},
-        {"wsf", "Windows Script File"},
-        {"asp", "Active Server Page"},
-        {"aspx", "Active Server Page Extended"},
-        {"jsp", "Java Server Page"},
-        {"cfm", "ColdFusion Markup"},
-        {"pl", "Perl Script"},
-        {"lua", "Lua Script"},
-        {"swift", "Swift Source File"},
-        {"kt", "Kotlin Source File"},
-        {"dart", "Dart Source File"},
-        {"scala", "Scala Source File"},
-        {"rs", "Rust Source File"},
-        {"m", "Objective-C Source File"},
-        {"mm", "Objective-C++ Source File"},
-        {"vb", "Visual Basic File"},
-        {"fs", "F# Source File"},
-        {"cs", "C# Source File"},
-        {"sln", "Visual Studio Solution"},
-        {"vcxproj", "Visual C++ Project"},
-        {"xcodeproj", "Xcode Project"},
-        {"pro", "Qt Project File"},
-        {"cmake", "CMake File"},
-        {"makefile", "Makefile"},
-        {"gradle", "Gradle Build File"},
-        {"pom", "Maven Project Object Model"},
-        {"lock", "Lock File"},
-        {"manifest", "Manifest File"},
-        {"resx", ".NET Resource File"},
-        {"dll", "Dynamic Link Library"},
-        {"lib", "Static Library"},
-        {"obj", "Object File"},
-        {"pdb", "Program Database"},
-        {"suo", "Solution User Options"},
-        {"user", "User Options File"},
-        {"nupkg", "NuGet Package"},
-        {"nuspec", "NuGet Specification"},
-        {"vsix", "Visual Studio Extension"},
-        {"xaml", "XAML File"},
-        {"ps1", "PowerShell Script"},
-        {"reg", "Registry File"},
-        {"scr", "Screensaver File"},
-        {"lnk", "Shortcut File"},
-        {"url", "Internet Shortcut"},
-        {"desktop", "Desktop Entry"},
-        {"cfg", "Configuration File"},
-        {"conf", "Configuration File"},
-        {"properties", "Properties File"},
-        {"env", "Environment File"},
-        {"rc", "Run Commands File"},
-        {"service", "Systemd Service File"},
-        {"plist", "Property List"},
-        {"dbf", "Database File"},
-        {"mdb", "Microsoft Access Database"},
-        {"accdb", "Microsoft Access Database"},
-        {"sql", "SQL File"},
-        {"bak", "Backup File"},
-        {"tmp", "Temporary File"},
-        {"swf", "Shockwave Flash Format"}
-    };
-    std::string lower_ext = ext;
-    for (auto& c : lower_ext) c = tolower(c);
-    auto it = type_map.find(lower_ext);
-    if (it != type_map.end()) return it->second;
-    return ext;
-}
+// If using a different backend (e.g., DirectX), adjust includes and init accordingly.
 
+// Tab title for a folder: its name, or the whole path for a drive root
+std::string FolderLabel(const std::string& path) {
+    size_t pos = path.length() > 1 ? path.find_last_of("\\/", path.length() - 2) : std::string::npos;
+    if (pos == std::string::npos) return path;
+    return path.substr(pos + 1, path.length() - pos - 2);
+}
 
-// If using a different backend (e.g., DirectX), adjust includes and init accordingly.
+// Local modification time for the listing, e.g. "2024-05-01 13:45"
+void FormatModifiedTime(long long seconds, char* out, size_t size) {
+    time_t time = (time_t)seconds;
+    struct tm local;
+    if (localtime_s(&local, &time) != 0 || strftime(out, size, "%Y-%m-%d %H:%M", &local) == 0) snprintf(out, size, "-");
+}
 
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 {
@@ -253,16 +123,35 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     bool show_window = true;
     static bool show_preferences = false; // Controls Preferences window visibility
-    // Async folder stats state
-    static std::thread folder_stats_thread;
-    static std::atomic<bool> folder_stats_running = false;
-    static std::atomic<bool> folder_stats_cancel = false;
-    static std::string folder_stats_path;
-    static FolderStats folder_stats_result;
+    static bool show_breakdown = false; // Controls Breakdown window visibility
+    static bool show_cache_stats = false; // Controls Cache Statistics window visibility
 
     // Track current directory for central window
-    std::string current_dir = "C:\\"; // Start at C:\
-    std::string selected_side_path = current_dir; // For side panel selection sync
+    // Browsing state: one or two panes of tabs. A tab is a cursor over the shared directory
+    // cache; it owns only its path and sort order, listings and folder sizes are shared.
+    struct BrowserTab {
+        int id = 0;
+        std::string path;
+        std::shared_ptr<DirectoryListing> listing;
+        unsigned long long listing_version = 0;
+        std::vector<size_t> row_order;
+        ImGuiTableColumnSortSpecs sort = {};
+        bool sort_dirty = true;
+        double sorted_at = 0.0;
+        unsigned long long sorted_generation = 0;
+    };
+    static std::vector<BrowserTab> pane_tabs[2];
+    static int pane_active_tab[2] = { 0, 0 };
+    static int focused_pane = 0;
+    static bool dual_pane = false;
+    static int next_tab_id = 0;
+    for (auto& tabs : pane_tabs) {
+        BrowserTab tab;
+        tab.id = next_tab_id++;
+        tab.path = "C:\\"; // Start at the C: drive
+        tabs.push_back(tab);
+    }
+    std::string selected_side_path = "C:\\"; // For side panel selection sync
     std::string selected_item_name; // For main panel selection
     bool selected_item_is_dir = false;
     std::string selected_item_fullpath;
@@ -271,6 +160,13 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     // Add a global variable for the preference
     static bool pref_show_item_checkboxes = false;
+    // Scan preferences (see ScanOptions)
+    static bool pref_scan_allocated_sizes = false;
+    static bool pref_scan_dedup_hard_links = false;
+    static bool pref_scan_one_file_system = false;
+    static bool pref_scan_follow_links = false;
+    // Memory the directory cache may use for listings and folder sizes no view shows
+    static int pref_cache_budget_mb = 64;
     static std::vector<std::string> checked_items; // store full paths
     // Persisted selected section for preferences (moved out so we can load/save it)
     static int selected_section = 0;
@@ -281,7 +177,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         // Default preferences
         nlohmann::json default_cfg = {
             {"show_item_checkboxes", false},
-            {"selected_section", 0}
+            {"selected_section", 0},
+            {"scan_allocated_sizes", false},
+            {"scan_dedup_hard_links", false},
+            {"scan_one_file_system", false},
+            {"scan_follow_links", false},
+            {"cache_budget_mb", 64}
         };
 
         bool loaded = read_json_file("config.json", cfg);
@@ -306,16 +207,62 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
             cfg["selected_section"] = default_cfg["selected_section"];
             need_persist = true;
         }
+        struct { const char* key; bool* value; } scan_prefs[] = {
+            {"scan_allocated_sizes", &pref_scan_allocated_sizes},
+            {"scan_dedup_hard_links", &pref_scan_dedup_hard_links},
+            {"scan_one_file_system", &pref_scan_one_file_system},
+            {"scan_follow_links", &pref_scan_follow_links}
+        };
+        for (auto& pref : scan_prefs) {
+            if (cfg.contains(pref.key) && cfg[pref.key].is_boolean()) {
+                *pref.value = cfg[pref.key].get<bool>();
+            } else {
+                cfg[pref.key] = default_cfg[pref.key];
+                need_persist = true;
+            }
+        }
+
+        if (cfg.contains("cache_budget_mb") && cfg["cache_budget_mb"].is_number_integer() && cfg["cache_budget_mb"].get<int>() > 0) {
+            pref_cache_budget_mb = cfg["cache_budget_mb"].get<int>();
+        } else {
+            cfg["cache_budget_mb"] = default_cfg["cache_budget_mb"];
+            need_persist = true;
+        }
 
         if (need_persist) {
             write_json_file("config.json", cfg);
         }
     }
 
-    // --- Folder size cache and async state for checkboxes ---
-    static std::unordered_map<std::string, ULONGLONG> checked_folder_size_cache;
-    static std::unordered_map<std::string, std::atomic<bool>> checked_folder_size_running;
-    static std::mutex checked_folder_size_mutex;
+    // Builds the scan options for new folder scans from the current preferences
+    auto current_scan_options = []() {
+        ScanOptions options;
+        options.allocated_sizes = pref_scan_allocated_sizes;
+        options.dedup_hard_links = pref_scan_dedup_hard_links;
+        options.one_file_system = pref_scan_one_file_system;
+        options.follow_links = pref_scan_follow_links;
+        return options;
+    };
+
+    // Mounts are enumerated and probed in the background so a hung drive never blocks the UI
+    static VolumeService volume_service;
+    volume_service.Start();
+
+    // --- Sizes of checked files; checked folders are scanned by the folder size service ---
+    static std::unordered_map<std::string, ULONGLONG> checked_file_sizes; // UI thread only
+    // Unchecks everything; the scans of checked folders stop once they are no longer focused
+    auto clear_checked_items = []() {
+        checked_items.clear();
+        checked_file_sizes.clear();
+    };
+    // Points a tab at another folder; checked items belong to the folder that was shown
+    auto navigate = [&](BrowserTab& tab, const std::string& path) {
+        tab.path = path;
+        clear_checked_items();
+    };
+
+    // Listings and folder sizes shared by every pane, tab and tree node
+    static DirectoryCache directory_cache;
 
     // Main loop
     while (show_window && !glfwWindowShouldClose(window))
@@ -327,6 +274,13 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // Refresh the shared listings once per frame, however many views show them
+        directory_cache.SetBudget((size_t)pref_cache_budget_mb << 20);
+        directory_cache.Update();
+        // Recursive size of every subfolder, computed in the background, rows on screen first
+        FolderSizeService& folder_sizes = directory_cache.Sizes();
+        folder_sizes.SetOptions(current_scan_options());
+
         // Set window background to black by clearing the screen
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -372,6 +326,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                 if (ImGui::MenuItem("Redo")) { /* handle Redo */ }
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("View")) {
+                ImGui::MenuItem("Breakdown", nullptr, &show_breakdown);
+                ImGui::MenuItem("Cache Statistics", nullptr, &show_cache_stats);
+                ImGui::EndMenu();
+            }
             // Add Settings menu
             if (ImGui::BeginMenu("Settings")) {
                 if (ImGui::MenuItem("Preferences")) { show_preferences = true; }
@@ -400,81 +359,67 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         ImGuiWindowFlags sidebar_flags = ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings;
         ImGui::Begin("Directory Tree", nullptr, sidebar_flags);
 
-        // Enumerate drives
-        char drives[256];
-        DWORD drive_count = GetLogicalDriveStringsA(sizeof(drives), drives);
-        for (char* drive = drives; *drive; drive += strlen(drive) + 1) {
-            std::string drive_str = drive;
+        // The tree shows and navigates the focused pane's current tab
+        BrowserTab& focused_tab = pane_tabs[focused_pane][pane_active_tab[focused_pane]];
+        const std::string& current_dir = focused_tab.path;
+
+        // List drives from the cached volume snapshot (never blocks on the drives themselves)
+        std::vector<VolumeInfo> volumes = volume_service.Snapshot();
+        for (const auto& volume : volumes) {
+            const std::string& drive_str = volume.root;
+            const char* drive = drive_str.c_str();
+            // Enumerate a drive only once a probe has answered; enumerating one whose
+            // probe is still running or hung would block the UI just the same
+            bool drive_responsive = (volume.state == VolumeState::Ready);
             bool drive_selected = (current_dir == drive_str);
             ImGuiTreeNodeFlags drive_flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
             if (drive_selected) drive_flags |= ImGuiTreeNodeFlags_Selected;
+            if (!drive_responsive) drive_flags |= ImGuiTreeNodeFlags_Leaf;
             bool drive_open = ImGui::TreeNodeEx(drive, drive_flags);
             // Click to select drive
-            if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
-                current_dir = drive_str;
-                checked_items.clear();
-                checked_folder_size_cache.clear();
-                checked_folder_size_running.clear();
+            if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen() && drive_responsive) {
+                navigate(focused_tab, drive_str);
             }
-            if (drive_open) {
-                // Enumerate folders and files in this drive
-                char search_path[MAX_PATH];
-                wsprintfA(search_path, "%s*", drive);
-                WIN32_FIND_DATAA find_data;
-                HANDLE hFind = FindFirstFileA(search_path, &find_data);
-                if (hFind != INVALID_HANDLE_VALUE) {
-                    do {
-                        if (strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0)
-                            continue;
-                        bool is_dir = (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-                        std::string folder_path = drive_str + std::string(find_data.cFileName) + "\\";
-                        std::string label = std::string(is_dir ? "[+] " : "[-] ") + find_data.cFileName;
-                        if (is_dir) {
-                            ImGuiTreeNodeFlags folder_flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
-                            if (current_dir == folder_path) folder_flags |= ImGuiTreeNodeFlags_Selected;
-                            bool folder_open = ImGui::TreeNodeEx(label.c_str(), folder_flags);
-                            // Click to select folder
-                            if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
-                                current_dir = folder_path;
-                                checked_items.clear();
-                                checked_folder_size_cache.clear();
-                                checked_folder_size_running.clear();
-                            }
-                            if (folder_open) {
-                                // Enumerate subfolders and files (one level deep)
-                                char subfolder_path[MAX_PATH];
-                                wsprintfA(subfolder_path, "%s%s\\", drive, find_data.cFileName);
-                                char sub_search[MAX_PATH];
-                                wsprintfA(sub_search, "%s*", subfolder_path);
-                                WIN32_FIND_DATAA sub_find;
-                                HANDLE hSubFind = FindFirstFileA(sub_search, &sub_find);
-                                if (hSubFind != INVALID_HANDLE_VALUE) {
-                                    do {
-                                        if (strcmp(sub_find.cFileName, ".") == 0 || strcmp(sub_find.cFileName, "..") == 0)
-                                            continue;
-                                        bool sub_is_dir = (sub_find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-                                        std::string sub_label = std::string(sub_is_dir ? "[+] " : "[-] ") + sub_find.cFileName;
-                                        std::string sub_path = folder_path + sub_find.cFileName + "\\";
-                                        ImGuiTreeNodeFlags sub_flags = 0;
-                                        if (current_dir == sub_path) sub_flags |= ImGuiTreeNodeFlags_Selected;
-                                        if (ImGui::Selectable(sub_label.c_str(), current_dir == sub_path, sub_flags)) {
-                                            if (sub_is_dir) {
-                                                current_dir = sub_path;
-                                                checked_items.clear();
-                                                checked_folder_size_cache.clear();
-                                                checked_folder_size_running.clear();
-                                            }
-                                        }
-                                    } while (FindNextFileA(hSubFind, &sub_find));
-                                    FindClose(hSubFind);
+            DrawVolumeUsage(volume);
+            if (drive_open && !drive_responsive) {
+                ImGui::TreePop();
+            } else if (drive_open) {
+                // Folders and files of this drive, enumerated once and shared through the cache
+                std::shared_ptr<DirectoryListing> drive_listing = directory_cache.Acquire(drive_str);
+                for (const ListingRow& drive_row : drive_listing->Rows()) {
+                    const VfsEntry& drive_entry = drive_row.entry;
+                    bool is_dir = drive_entry.is_dir;
+                    std::string folder_path = drive_str + drive_entry.name + "\\";
+                    std::string label = std::string(is_dir ? "[+] " : "[-] ") + drive_entry.name;
+                    if (is_dir) {
+                        ImGuiTreeNodeFlags folder_flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
+                        if (current_dir == folder_path) folder_flags |= ImGuiTreeNodeFlags_Selected;
+                        bool folder_open = ImGui::TreeNodeEx(label.c_str(), folder_flags);
+                        // Click to select folder
+                        if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
+                            navigate(focused_tab, folder_path);
+                        }
+                        if (folder_open) {
+                            // Enumerate subfolders and files (one level deep)
+                            std::shared_ptr<DirectoryListing> folder_listing = directory_cache.Acquire(folder_path);
+                            for (const ListingRow& sub_row : folder_listing->Rows()) {
+                                const VfsEntry& sub_entry = sub_row.entry;
+                                bool sub_is_dir = sub_entry.is_dir;
+                                std::string sub_label = std::string(sub_is_dir ? "[+] " : "[-] ") + sub_entry.name;
+                                std::string sub_path = folder_path + sub_entry.name + "\\";
+                                ImGuiTreeNodeFlags sub_flags = 0;
+                                if (current_dir == sub_path) sub_flags |= ImGuiTreeNodeFlags_Selected;
+                                if (ImGui::Selectable(sub_label.c_str(), current_dir == sub_path, sub_flags)) {
+                                    if (sub_is_dir) {
+                                        navigate(focused_tab, sub_path);
+                                    }
                                 }
-                                ImGui::TreePop();
                             }
-                        } else {
-                            ImGui::BulletText("%s", label.c_str());
+                            ImGui::TreePop();
                         }
-                    } while (FindNextFileA(hFind, &find_data));
-                    FindClose(hFind);
+                    } else {
+                        ImGui::BulletText("%s", label.c_str());
+                    }
                 }
                 ImGui::TreePop();
             }
@@ -487,20 +432,8 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         ImGui::SetNextWindowSize(center_size);
         ImGuiWindowFlags center_flags = ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings;
         ImGui::Begin("Central Window", nullptr, center_flags);
-        // Always show Back button, only navigate if not at root
-        if (ImGui::Button("Back")) {
-            if (current_dir != "C:\\") {
-                size_t pos = current_dir.find_last_of("\\/", current_dir.length() - 2);
-                if (pos != std::string::npos) {
-                    current_dir = current_dir.substr(0, pos + 1);
-                    checked_items.clear();
-                    checked_folder_size_cache.clear();
-                    checked_folder_size_running.clear();
-                }
-            }
-        }
-        ImGui::SameLine();
-        ImGui::Text("Current Directory: %s", current_dir.c_str());
+        ImGui::Checkbox("Dual pane", &dual_pane);
+        if (!dual_pane) focused_pane = 0;
         ImGui::Separator();
 
         // List folders and files with type column
@@ -516,179 +449,324 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         static ULONGLONG checked_total_size = 0;
         int checked_count = 0;
         checked_total_size = 0;
-        ImGui::Columns(2, nullptr, true);
-        ImGui::Text("Name"); ImGui::NextColumn();
-        ImGui::Text("Type"); ImGui::NextColumn();
-        ImGui::Separator();
-        char search_path[MAX_PATH];
-        wsprintfA(search_path, "%s*", current_dir.c_str());
-        WIN32_FIND_DATAA find_data;
-        HANDLE hFind = FindFirstFileA(search_path, &find_data);
-        int item_index = 0;
-        int selected_index = -1;
-        if (hFind != INVALID_HANDLE_VALUE) {
-            do {
-                if (strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0)
+        int checked_calculating = 0;
+        double checked_files_per_second = 0.0;
+        double checked_eta_seconds = 0.0; // longest of the running scans; negative while any is unknown
+        // --- Calculate checked size/count ---
+        // The selected and checked folders are scanned first, sharing the walks of the size column
+        std::vector<std::string> focused_folders;
+        if (pref_show_item_checkboxes) {
+            for (const auto& path : checked_items) {
+                if (path.back() == '\\') focused_folders.push_back(path);
+            }
+        }
+        if (selected_item_is_dir && !selected_item_fullpath.empty()) focused_folders.push_back(selected_item_fullpath);
+        folder_sizes.Focus(focused_folders, show_breakdown);
+
+        if (pref_show_item_checkboxes) {
+            for (const auto& path : checked_items) {
+                checked_count++;
+                // Running scans count with their totals so far
+                if (path.back() == '\\') {
+                    ScanProgress progress = folder_sizes.Progress(path);
+                    checked_total_size += progress.stats.size;
+                    if (!IsFinished(progress.state)) {
+                        checked_calculating++;
+                        checked_files_per_second += progress.files_per_second;
+                        checked_eta_seconds = (progress.eta_seconds < 0.0 || checked_eta_seconds < 0.0)
+                                                  ? -1.0 : std::max(checked_eta_seconds, progress.eta_seconds);
+                    }
                     continue;
-                bool is_dir = (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-                if (is_dir) folder_count++; else file_count++;
-                std::string item_name = find_data.cFileName;
-                std::string label = std::string(is_dir ? "[+] " : "[-] ") + item_name;
-                std::string full_path = current_dir + item_name + (is_dir ? "\\" : "");
-                bool is_selected = (selected_item_fullpath == full_path);
-                // --- Checkbox logic ---
-                bool checked = false;
-                if (pref_show_item_checkboxes) {
-                    auto it = std::find(checked_items.begin(), checked_items.end(), full_path);
-                    checked = (it != checked_items.end());
-                    ImGui::PushID(item_index);
-                    if (ImGui::Checkbox("", &checked)) {
-                        if (checked) {
-                            checked_items.push_back(full_path);
-                            // If it's a folder and not already being calculated, start async size calc
-                            if (is_dir && checked_folder_size_cache.find(full_path) == checked_folder_size_cache.end() && checked_folder_size_running.find(full_path) == checked_folder_size_running.end()) {
-                                checked_folder_size_running[full_path] = true;
-                                std::thread([full_path]() {
-                                    FolderStats stats;
-                                    GetFolderStatsRecursive(full_path, stats);
-                                    std::lock_guard<std::mutex> lock(checked_folder_size_mutex);
-                                    checked_folder_size_cache[full_path] = stats.size;
-                                    checked_folder_size_running[full_path] = false;
-                                }).detach();
-                            }
-                        } else {
-                            checked_items.erase(std::remove(checked_items.begin(), checked_items.end(), full_path), checked_items.end());
-                            // Remove from cache and running
-                            std::lock_guard<std::mutex> lock(checked_folder_size_mutex);
-                            checked_folder_size_cache.erase(full_path);
-                            checked_folder_size_running.erase(full_path);
+                }
+                auto file = checked_file_sizes.find(path);
+                if (file != checked_file_sizes.end()) checked_total_size += file->second;
+            }
+        }
+        // --- End checked size/count ---
+
+        // Rows on screen in every pane: their metadata is loaded and their folders are scanned first.
+        // Keyed by owning pointer, as a tab closed later this frame may hold the only reference.
+        std::unordered_map<std::shared_ptr<DirectoryListing>, std::vector<size_t>> visible_rows;
+        std::vector<std::string> visible_folders;
+        bool views_changed = false;
+
+        // Draws one tab: its listing comes from the shared cache, only the sort order is its own
+        auto draw_tab = [&](BrowserTab& tab, bool focused) {
+            ImGui::PushID(tab.id);
+            // Always show Back button, only navigate if not at root
+            if (ImGui::Button("Back")) {
+                if (tab.path != "C:\\") {
+                    size_t pos = tab.path.find_last_of("\\/", tab.path.length() - 2);
+                    if (pos != std::string::npos) navigate(tab, tab.path.substr(0, pos + 1));
+                }
+            }
+            ImGui::SameLine();
+            ImGui::Text("Current Directory: %s", tab.path.c_str());
+            ImGui::Separator();
+
+            // Names are listed at once; size and modified time fill in as the metadata loader delivers them
+            bool listing_opened = false;
+            if (!tab.listing || tab.listing->Path() != tab.path) {
+                tab.listing = directory_cache.Acquire(tab.path);
+                listing_opened = true;
+                views_changed = true;
+            }
+            DirectoryListing& listing = *tab.listing;
+            bool listing_updated = listing.Version() != tab.listing_version;
+            tab.listing_version = listing.Version();
+            const std::vector<ListingRow>& listing_rows = listing.Rows();
+            // Rows keep the folder they were listed from, even if this frame navigates away
+            const std::string dir = tab.path;
+            auto row_path = [&](const ListingRow& row) {
+                return dir + row.entry.name + (row.entry.is_dir ? "\\" : "");
+            };
+            if (focused) {
+                for (const ListingRow& row : listing_rows) {
+                    if (row.entry.is_dir) folder_count++; else file_count++;
+                }
+            }
+
+            const ImGuiTableFlags listing_flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg |
+                                                  ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY;
+            if (ImGui::BeginTable("##listing", 4, listing_flags)) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+                ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed, 110.0f);
+                ImGui::TableSetupColumn("Modified", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed, 130.0f);
+                ImGui::TableHeadersRow();
+                if (ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs()) {
+                    if (sort_specs->SpecsDirty) {
+                        if (sort_specs->SpecsCount > 0) tab.sort = sort_specs->Specs[0];
+                        tab.sort_dirty = true;
+                        sort_specs->SpecsDirty = false;
+                    }
+                }
+                // Display order of the rows, re-sorted when the sort spec or the rows change. While
+                // sizes and metadata are still landing, re-sorting is limited to a few times a second.
+                bool results_landed = listing_updated || folder_sizes.Generation() != tab.sorted_generation;
+                if (listing_opened || tab.row_order.size() != listing_rows.size() ||
+                    (results_landed && ImGui::GetTime() - tab.sorted_at > 0.25)) {
+                    tab.sort_dirty = true;
+                }
+                if (tab.sort_dirty) {
+                    // Keys are computed once per sort, not once per comparison
+                    std::vector<unsigned long long> size_keys(listing_rows.size());
+                    std::vector<std::string> type_keys(tab.sort.ColumnIndex == 1 ? listing_rows.size() : 0);
+                    for (size_t i = 0; i < listing_rows.size(); ++i) {
+                        const VfsEntry& entry = listing_rows[i].entry;
+                        size_keys[i] = entry.is_dir ? folder_sizes.Lookup(row_path(listing_rows[i])).stats.size : entry.size;
+                        if (!type_keys.empty()) {
+                            const char* ext = strrchr(entry.name.c_str(), '.');
+                            type_keys[i] = entry.is_dir ? "" : (ext && ext != entry.name.c_str() ? GetFileTypeName(ext + 1) : "file");
                         }
                     }
-                    ImGui::PopID();
-                    ImGui::SameLine();
+                    tab.row_order.resize(listing_rows.size());
+                    for (size_t i = 0; i < listing_rows.size(); ++i) tab.row_order[i] = i;
+                    const bool ascending = tab.sort.SortDirection != ImGuiSortDirection_Descending;
+                    std::stable_sort(tab.row_order.begin(), tab.row_order.end(), [&](size_t a, size_t b) {
+                        const VfsEntry& ea = listing_rows[a].entry;
+                        const VfsEntry& eb = listing_rows[b].entry;
+                        int cmp = 0;
+                        switch (tab.sort.ColumnIndex) {
+                        case 1: cmp = type_keys[a].compare(type_keys[b]); break;
+                        case 2: cmp = (size_keys[a] < size_keys[b]) ? -1 : (size_keys[a] > size_keys[b] ? 1 : 0); break;
+                        case 3: cmp = (ea.modified < eb.modified) ? -1 : (ea.modified > eb.modified ? 1 : 0); break;
+                        default:
+                            // Folders before files, like the sidebar
+                            if (ea.is_dir != eb.is_dir) return ea.is_dir;
+                            break;
+                        }
+                        if (cmp == 0) cmp = _stricmp(ea.name.c_str(), eb.name.c_str());
+                        return ascending ? cmp < 0 : cmp > 0;
+                    });
+                    tab.sorted_at = ImGui::GetTime();
+                    tab.sorted_generation = folder_sizes.Generation();
+                    tab.sort_dirty = false;
                 }
-                // --- End Checkbox logic ---
-                // --- Selectable with double-click folder open ---
-                if (ImGui::Selectable(label.c_str(), is_selected, ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns)) {
-                    selected_item_name = item_name;
-                    selected_item_is_dir = is_dir;
-                    selected_item_fullpath = full_path;
-                    selected_file_size = 0;
-                    selected_folder_subfolders = 0;
-                    selected_folder_files = 0;
-                    selected_folder_size = 0;
-                    if (!is_dir) {
-                        // Get file size
-                        HANDLE hFile = CreateFileA(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-                        if (hFile != INVALID_HANDLE_VALUE) {
-                            LARGE_INTEGER size;
-                            if (GetFileSizeEx(hFile, &size)) {
-                                selected_file_size = size.QuadPart;
+
+                // Only the rows on screen are drawn
+                std::vector<size_t> tab_visible;
+                ImGuiListClipper clipper;
+                clipper.Begin((int)tab.row_order.size());
+                while (clipper.Step()) {
+                    for (int item_index = clipper.DisplayStart; item_index < clipper.DisplayEnd; ++item_index) {
+                        const size_t row_index = tab.row_order[item_index];
+                        tab_visible.push_back(row_index);
+                        const ListingRow& row = listing_rows[row_index];
+                        const VfsEntry& entry = row.entry;
+                        bool is_dir = entry.is_dir;
+                        const std::string& item_name = entry.name;
+                        std::string label = std::string(is_dir ? "[+] " : "[-] ") + item_name;
+                        std::string full_path = row_path(row);
+                        bool is_selected = (selected_item_fullpath == full_path);
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        // --- Checkbox logic ---
+                        bool checked = false;
+                        if (pref_show_item_checkboxes) {
+                            auto it = std::find(checked_items.begin(), checked_items.end(), full_path);
+                            checked = (it != checked_items.end());
+                            ImGui::PushID(item_index);
+                            if (ImGui::Checkbox("", &checked)) {
+                                if (checked) {
+                                    // A checked folder is focused in the folder size service from the next frame on
+                                    checked_items.push_back(full_path);
+                                    if (!is_dir) {
+                                        VfsEntry file_entry;
+                                        if (row.has_metadata) checked_file_sizes[full_path] = entry.size;
+                                        else if (NativeVfs().Stat(full_path, file_entry, kVfsSize)) checked_file_sizes[full_path] = file_entry.size;
+                                    }
+                                } else {
+                                    checked_items.erase(std::remove(checked_items.begin(), checked_items.end(), full_path), checked_items.end());
+                                    checked_file_sizes.erase(full_path);
+                                }
                             }
-                            CloseHandle(hFile);
-                        }
-                        // Cancel any running folder stats thread
-                        if (folder_stats_running) {
-                            folder_stats_cancel = true;
-                            if (folder_stats_thread.joinable()) folder_stats_thread.join();
-                            folder_stats_running = false;
+                            ImGui::PopID();
+                            ImGui::SameLine();
                         }
-                    } else {
-                        // Cancel any running folder stats thread
-                        if (folder_stats_running) {
-                            folder_stats_cancel = true;
-                            if (folder_stats_thread.joinable()) folder_stats_thread.join();
-                            folder_stats_running = false;
+                        // --- End Checkbox logic ---
+                        // --- Selectable with double-click folder open ---
+                        if (ImGui::Selectable(label.c_str(), is_selected, ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns)) {
+                            selected_item_name = item_name;
+                            selected_item_is_dir = is_dir;
+                            selected_item_fullpath = full_path;
+                            selected_file_size = 0;
+                            selected_folder_subfolders = 0;
+                            selected_folder_files = 0;
+                            selected_folder_size = 0;
+                            if (!is_dir) {
+                                VfsEntry file_entry;
+                                if (row.has_metadata) selected_file_size = entry.size;
+                                else if (NativeVfs().Stat(full_path, file_entry, kVfsSize)) selected_file_size = file_entry.size;
+                            } else {
+                                // Count immediate subfolders and files (non-recursive); the recursive
+                                // totals come from the folder size service, which focuses on the selection
+                                std::shared_ptr<DirectoryListing> sub_listing = directory_cache.Acquire(full_path);
+                                for (const ListingRow& sub_row : sub_listing->Rows()) {
+                                    if (sub_row.entry.is_dir)
+                                        selected_folder_subfolders++;
+                                    else
+                                        selected_folder_files++;
+                                }
+                            }
                         }
-                        // Count immediate subfolders and files (non-recursive)
-                        char sub_search[MAX_PATH];
-                        wsprintfA(sub_search, "%s*", full_path.c_str());
-                        WIN32_FIND_DATAA sub_find;
-                        HANDLE hSubFind = FindFirstFileA(sub_search, &sub_find);
-                        if (hSubFind != INVALID_HANDLE_VALUE) {
-                            do {
-                                if (strcmp(sub_find.cFileName, ".") == 0 || strcmp(sub_find.cFileName, "..") == 0)
-                                    continue;
-                                if (sub_find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-                                    selected_folder_subfolders++;
-                                else
-                                    selected_folder_files++;
-                            } while (FindNextFileA(hSubFind, &sub_find));
-                            FindClose(hSubFind);
+                        // --- Double-click to open folder ---
+                        if (is_dir && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
+                            navigate(tab, full_path);
+                            selected_item_fullpath.clear();
                         }
-                        // Start async folder stats computation (recursive size and file count)
-                        folder_stats_path = full_path;
-                        folder_stats_result = FolderStats();
-                        folder_stats_cancel = false;
-                        folder_stats_running = true;
-                        folder_stats_thread = std::thread([full_path]() {
-                            FolderStats stats;
-                            GetFolderStatsRecursive(full_path, stats, &folder_stats_cancel);
-                            if (!folder_stats_cancel) {
-                                folder_stats_result = stats;
+                        // --- End double-click logic ---
+                        ImGui::TableSetColumnIndex(1);
+                        if (is_dir) {
+                            ImGui::TextUnformatted("folder");
+                        } else {
+                            const char* ext = strrchr(item_name.c_str(), '.');
+                            if (ext && ext != item_name.c_str()) {
+                                std::string ext_str = ext + 1;
+                                ImGui::TextUnformatted(GetFileTypeName(ext_str).c_str());
+                            } else {
+                                ImGui::TextUnformatted("file");
                             }
-                            folder_stats_running = false;
-                        });
-                        if (folder_stats_thread.joinable()) folder_stats_thread.detach();
+                        }
+                        ImGui::TableSetColumnIndex(2);
+                        char size_str[32];
+                        if (is_dir) {
+                            // Recursive size; partial totals are shown dimmed while the scan runs
+                            FolderSize folder_size = folder_sizes.Lookup(full_path);
+                            FormatByteSize(folder_size.stats.size, size_str, sizeof(size_str));
+                            if (folder_size.state == FolderSizeState::Done) ImGui::TextUnformatted(size_str);
+                            else if (folder_size.state == FolderSizeState::Running) ImGui::TextDisabled("%s...", size_str);
+                            else if (folder_size.state == FolderSizeState::Error) ImGui::TextDisabled("?");
+                            else ImGui::TextDisabled("...");
+                        } else if (row.has_metadata) {
+                            FormatByteSize(entry.size, size_str, sizeof(size_str));
+                            ImGui::TextUnformatted(size_str);
+                        } else {
+                            ImGui::TextDisabled("...");
+                        }
+                        ImGui::TableSetColumnIndex(3);
+                        if (row.has_metadata) {
+                            char time_str[32];
+                            FormatModifiedTime(entry.modified, time_str, sizeof(time_str));
+                            ImGui::TextUnformatted(time_str);
+                        } else {
+                            ImGui::TextDisabled("...");
+                        }
                     }
                 }
-                // --- Double-click to open folder ---
-                if (is_dir && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
-                    current_dir = full_path;
-                    selected_item_fullpath.clear();
-                    checked_items.clear();
-                    checked_folder_size_cache.clear();
-                    checked_folder_size_running.clear();
-                    // Cancel any running folder stats thread
-                    if (folder_stats_running) {
-                        folder_stats_cancel = true;
-                        if (folder_stats_thread.joinable()) folder_stats_thread.join();
-                        folder_stats_running = false;
-                    }
+                ImGui::EndTable();
+
+                std::vector<size_t>& shown = visible_rows[tab.listing];
+                shown.insert(shown.end(), tab_visible.begin(), tab_visible.end());
+                for (size_t row_index : tab_visible) {
+                    if (listing_rows[row_index].entry.is_dir) visible_folders.push_back(row_path(listing_rows[row_index]));
                 }
-                // --- End double-click logic ---
-                // --- Calculate checked size/count ---
-                if (pref_show_item_checkboxes && checked) {
-                    checked_count++;
-                    if (is_dir) {
-                        std::lock_guard<std::mutex> lock(checked_folder_size_mutex);
-                        auto it = checked_folder_size_cache.find(full_path);
-                        if (it != checked_folder_size_cache.end()) {
-                            checked_total_size += it->second;
+            }
+            ImGui::PopID();
+        };
+
+        // One or two panes side by side, each a tab bar; the tree and the status bar follow the focused pane
+        const int pane_count = dual_pane ? 2 : 1;
+        if (ImGui::BeginTable("##panes", pane_count, ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersInnerV, ImGui::GetContentRegionAvail())) {
+            for (int pane = 0; pane < pane_count; ++pane) {
+                ImGui::TableNextColumn();
+                ImGui::PushID(pane);
+                ImGui::BeginChild("##pane");
+                std::vector<BrowserTab>& tabs = pane_tabs[pane];
+                if (ImGui::BeginTabBar("##tabs", ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_FittingPolicyScroll)) {
+                    for (size_t i = 0; i < tabs.size();) {
+                        bool open = true;
+                        std::string tab_label = FolderLabel(tabs[i].path) + "###tab" + std::to_string(tabs[i].id);
+                        if (ImGui::BeginTabItem(tab_label.c_str(), tabs.size() > 1 ? &open : nullptr)) {
+                            pane_active_tab[pane] = (int)i;
+                            draw_tab(tabs[i], pane == focused_pane);
+                            ImGui::EndTabItem();
                         }
-                    } else {
-                        HANDLE hFile = CreateFileA(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-                        if (hFile != INVALID_HANDLE_VALUE) {
-                            LARGE_INTEGER size;
-                            if (GetFileSizeEx(hFile, &size)) {
-                                checked_total_size += size.QuadPart;
-                            }
-                            CloseHandle(hFile);
+                        if (!open) {
+                            tabs.erase(tabs.begin() + i);
+                            views_changed = true;
+                        } else {
+                            ++i;
                         }
                     }
+                    // New tab on the folder of the current one
+                    if (ImGui::TabItemButton("+", ImGuiTabItemFlags_Trailing | ImGuiTabItemFlags_NoTooltip)) {
+                        BrowserTab tab;
+                        tab.id = next_tab_id++;
+                        tab.path = tabs[std::min(pane_active_tab[pane], (int)tabs.size() - 1)].path;
+                        tabs.push_back(tab);
+                    }
+                    ImGui::EndTabBar();
                 }
-                // --- End checked size/count ---
-                ImGui::NextColumn();
-                if (is_dir) {
-                    ImGui::TextUnformatted("folder");
-                } else {
-                    const char* ext = strrchr(item_name.c_str(), '.');
-                    if (ext && ext != item_name.c_str()) {
-                        std::string ext_str = ext + 1;
-                        ImGui::TextUnformatted(GetFileTypeName(ext_str).c_str());
-                    } else {
-                        ImGui::TextUnformatted("file");
+                pane_active_tab[pane] = std::min(pane_active_tab[pane], (int)tabs.size() - 1);
+                // Clicking anywhere in a pane focuses it
+                if (ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows) && ImGui::IsMouseClicked(0)) focused_pane = pane;
+                ImGui::EndChild();
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+
+        // Visible rows first, for both the metadata loads and the folder scans. Views on the
+        // same folder share one listing, and views on nested folders share the scans.
+        for (auto& shown : visible_rows) shown.first->SetVisibleRows(shown.second);
+        static std::vector<std::string> requested_visible_folders;
+        if (views_changed || visible_folders != requested_visible_folders) {
+            requested_visible_folders = visible_folders;
+            std::vector<std::string> folders = visible_folders;
+            for (int pane = 0; pane < pane_count; ++pane) {
+                const BrowserTab& tab = pane_tabs[pane][pane_active_tab[pane]];
+                if (!tab.listing) continue;
+                const std::vector<ListingRow>& listing_rows = tab.listing->Rows();
+                for (size_t row_index : tab.row_order) {
+                    if (row_index < listing_rows.size() && listing_rows[row_index].entry.is_dir) {
+                        folders.push_back(tab.listing->Path() + listing_rows[row_index].entry.name + "\\");
                     }
                 }
-                ImGui::NextColumn();
-                item_index++;
-            } while (FindNextFileA(hFind, &find_data));
-            FindClose(hFind);
+            }
+            folder_sizes.Request(folders);
         }
-        ImGui::Columns(1);
-        // --- Show checked summary ---
-        // (Removed: do not show selected item count and size here)
-        // --- End checked summary ---
         ImGui::End();
 
         // Draw fixed status bar at the bottom
@@ -701,38 +779,58 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         if (pref_show_item_checkboxes && checked_count > 0) {
             char checked_info[256];
             double size = (double)checked_total_size;
-            int calculating = 0;
-            for (const auto& path : checked_items) {
-                if (checked_folder_size_running.count(path) && checked_folder_size_running[path]) calculating++;
+            char calculating[128] = "";
+            if (checked_calculating > 0) {
+                char eta_str[32] = "?";
+                if (checked_eta_seconds >= 0.0) FormatDuration(checked_eta_seconds, eta_str, sizeof(eta_str));
+                snprintf(calculating, sizeof(calculating), " (Calculating %d... %.0f files/s, ETA %s)", checked_calculating, checked_files_per_second, eta_str);
             }
             if (size < 1024) {
-                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %llu bytes%s", checked_count, checked_total_size, calculating ? " (Calculating...)" : "");
+                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %llu bytes%s", checked_count, checked_total_size, calculating);
             } else if (size < 1024 * 1024) {
-                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f KB%s", checked_count, size / 1024.0, calculating ? " (Calculating...)" : "");
+                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f KB%s", checked_count, size / 1024.0, calculating);
             } else if (size < 1024 * 1024 * 1024) {
-                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f MB%s", checked_count, size / (1024.0 * 1024.0), calculating ? " (Calculating...)" : "");
+                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f MB%s", checked_count, size / (1024.0 * 1024.0), calculating);
             } else {
-                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f GB%s", checked_count, size / (1024.0 * 1024.0 * 1024.0), calculating ? " (Calculating...)" : "");
+                snprintf(checked_info, sizeof(checked_info), "Selected: %d | Size: %.2f GB%s", checked_count, size / (1024.0 * 1024.0 * 1024.0), calculating);
             }
             ImGui::Text("%s", checked_info);
         } else if (!selected_item_fullpath.empty()) {
             if (selected_item_is_dir) {
-                if (folder_stats_running && folder_stats_path == selected_item_fullpath) {
+                ScanProgress folder_progress = folder_sizes.Progress(selected_item_fullpath);
+                const FolderStats& folder_stats = folder_progress.stats;
+                if (folder_progress.state == ScanState::Running) {
+                    // Live totals while the scan runs
+                    char size_str[32];
+                    char eta_str[32] = "?";
+                    FormatByteSize(folder_stats.size, size_str, sizeof(size_str));
+                    if (folder_progress.eta_seconds >= 0.0) FormatDuration(folder_progress.eta_seconds, eta_str, sizeof(eta_str));
+                    ImGui::Text("Folder: %s | Subfolders: %d | Files: %d | Size: %s so far (%llu files, %llu folders) | %.0f files/s | ETA %s | %s",
+                        selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files, size_str,
+                        folder_stats.files, folder_stats.dirs, folder_progress.files_per_second, eta_str, folder_progress.current);
+                } else if (folder_progress.state == ScanState::Idle) {
+                    // Queued in the folder size service
                     ImGui::Text("Folder: %s | Subfolders: %d | Files: %d | Size: Calculating...", selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files);
-                } else if (folder_stats_path == selected_item_fullpath) {
+                } else if (folder_progress.state == ScanState::Done || folder_progress.state == ScanState::Error) {
                     // Format folder size dynamically
                     char size_str[64];
-                    double size = (double)folder_stats_result.size;
+                    double size = (double)folder_stats.size;
                     if (size < 1024) {
-                        snprintf(size_str, sizeof(size_str), "%llu bytes", folder_stats_result.size);
+                        snprintf(size_str, sizeof(size_str), "%llu bytes", folder_stats.size);
                     } else if (size < 1024 * 1024) {
-                        snprintf(size_str, sizeof(size_str), "%.2f KB (%llu bytes)", size / 1024.0, folder_stats_result.size);
+                        snprintf(size_str, sizeof(size_str), "%.2f KB (%llu bytes)", size / 1024.0, folder_stats.size);
                     } else if (size < 1024 * 1024 * 1024) {
-                        snprintf(size_str, sizeof(size_str), "%.2f MB (%llu bytes)", size / (1024.0 * 1024.0), folder_stats_result.size);
+                        snprintf(size_str, sizeof(size_str), "%.2f MB (%llu bytes)", size / (1024.0 * 1024.0), folder_stats.size);
+                    } else {
+                        snprintf(size_str, sizeof(size_str), "%.2f GB (%llu bytes)", size / (1024.0 * 1024.0 * 1024.0), folder_stats.size);
+                    }
+                    if (folder_stats.allocated > 0) {
+                        char allocated_str[32];
+                        FormatByteSize(folder_stats.allocated, allocated_str, sizeof(allocated_str));
+                        ImGui::Text("Folder: %s | Subfolders: %d | Files: %d | Size: %s | On disk: %s", selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files, size_str, allocated_str);
                     } else {
-                        snprintf(size_str, sizeof(size_str), "%.2f GB (%llu bytes)", size / (1024.0 * 1024.0 * 1024.0), folder_stats_result.size);
+                        ImGui::Text("Folder: %s | Subfolders: %d | Files: %d | Size: %s", selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files, size_str);
                     }
-                    ImGui::Text("Folder: %s | Subfolders: %d | Files: %d | Size: %s", selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files, size_str);
                 } else {
                     ImGui::Text("Folder: %s | Subfolders: %d | Files: %d", selected_item_name.c_str(), selected_folder_subfolders, selected_folder_files);
                 }
@@ -758,6 +856,145 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         }
         ImGui::End();
 
+        // Breakdown window: per-type totals and largest files of the current selection
+        if (show_breakdown) {
+            ImGui::SetNextWindowSize(ImVec2(640, 480), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Breakdown", &show_breakdown)) {
+                // Merge the per-scan accumulators that make up the selection
+                ScanBreakdown selection_breakdown;
+                int breakdown_pending = 0;
+                bool breakdown_has_selection = false;
+                if (pref_show_item_checkboxes && !checked_items.empty()) {
+                    breakdown_has_selection = true;
+                    for (const auto& path : checked_items) {
+                        if (path.back() == '\\') {
+                            // Walked by the folder size service while this window is open
+                            if (auto breakdown = folder_sizes.Breakdown(path)) selection_breakdown.Merge(*breakdown);
+                            else breakdown_pending++;
+                        } else {
+                            // Sizes recorded when the file was checked; never touch the disk per frame
+                            auto file = checked_file_sizes.find(path);
+                            if (file != checked_file_sizes.end()) {
+                                size_t pos = path.find_last_of("\\/");
+                                selection_breakdown.AddFile(path.substr(0, pos + 1), path.c_str() + pos + 1, file->second);
+                            }
+                        }
+                    }
+                } else if (!selected_item_fullpath.empty() && selected_item_is_dir) {
+                    breakdown_has_selection = true;
+                    if (auto breakdown = folder_sizes.Breakdown(selected_item_fullpath)) selection_breakdown.Merge(*breakdown);
+                    else breakdown_pending++;
+                }
+
+                static std::string breakdown_export_status;
+                if (!breakdown_has_selection) {
+                    ImGui::TextDisabled("Select a folder or check items to see their breakdown.");
+                } else {
+                    char total_str[32];
+                    FormatByteSize(selection_breakdown.TotalBytes(), total_str, sizeof(total_str));
+                    ImGui::Text("Files: %llu | Size: %s%s", selection_breakdown.TotalFiles(), total_str, breakdown_pending ? " (Calculating...)" : "");
+                    if (ImGui::Button("Export CSV")) {
+                        std::ofstream out("breakdown.csv");
+                        breakdown_export_status = (out.is_open() && WriteBreakdownCsv(selection_breakdown, out)) ? "Exported to breakdown.csv" : "Failed to write breakdown.csv";
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Export JSON")) {
+                        std::ofstream out("breakdown.json");
+                        breakdown_export_status = (out.is_open() && WriteBreakdownJson(selection_breakdown, out)) ? "Exported to breakdown.json" : "Failed to write breakdown.json";
+                    }
+                    if (!breakdown_export_status.empty()) {
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("%s", breakdown_export_status.c_str());
+                    }
+
+                    // Types table, sortable by any column
+                    struct BreakdownRow {
+                        std::string type;
+                        unsigned long long files;
+                        unsigned long long bytes;
+                    };
+                    std::vector<BreakdownRow> rows;
+                    const auto& types = selection_breakdown.Types();
+                    for (size_t id = 0; id < types.size(); ++id) {
+                        if (types[id].files > 0) rows.push_back({ GetFileTypeNameById((int)id), types[id].files, types[id].bytes });
+                    }
+                    ImGuiTableFlags table_flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders |
+                                                  ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+                    if (ImGui::BeginTable("##breakdown_types", 4, table_flags, ImVec2(0, ImGui::GetContentRegionAvail().y * 0.55f))) {
+                        ImGui::TableSetupColumn("Type");
+                        ImGui::TableSetupColumn("Files", ImGuiTableColumnFlags_PreferSortDescending);
+                        ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+                        ImGui::TableSetupColumn("Share", ImGuiTableColumnFlags_PreferSortDescending);
+                        ImGui::TableSetupScrollFreeze(0, 1);
+                        ImGui::TableHeadersRow();
+                        // Rows are rebuilt every frame, so always apply the current sort spec
+                        if (ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs()) {
+                            if (sort_specs->SpecsCount > 0) {
+                                const ImGuiTableColumnSortSpecs& spec = sort_specs->Specs[0];
+                                bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+                                std::sort(rows.begin(), rows.end(), [&](const BreakdownRow& a, const BreakdownRow& b) {
+                                    int cmp = 0;
+                                    if (spec.ColumnIndex == 0) cmp = a.type.compare(b.type);
+                                    else if (spec.ColumnIndex == 1) cmp = (a.files < b.files) ? -1 : (a.files > b.files ? 1 : 0);
+                                    else cmp = (a.bytes < b.bytes) ? -1 : (a.bytes > b.bytes ? 1 : 0);
+                                    return ascending ? cmp < 0 : cmp > 0;
+                                });
+                            }
+                            sort_specs->SpecsDirty = false;
+                        }
+                        double total = (double)selection_breakdown.TotalBytes();
+                        for (const auto& row : rows) {
+                            char size_str[32];
+                            FormatByteSize(row.bytes, size_str, sizeof(size_str));
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn(); ImGui::TextUnformatted(row.type.c_str());
+                            ImGui::TableNextColumn(); ImGui::Text("%llu", row.files);
+                            ImGui::TableNextColumn(); ImGui::TextUnformatted(size_str);
+                            ImGui::TableNextColumn(); ImGui::Text("%.1f%%", total > 0 ? row.bytes * 100.0 / total : 0.0);
+                        }
+                        ImGui::EndTable();
+                    }
+
+                    // Largest files, biggest first
+                    if (ImGui::BeginTable("##breakdown_largest", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY)) {
+                        ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 110.0f);
+                        ImGui::TableSetupColumn("Largest files");
+                        ImGui::TableSetupScrollFreeze(0, 1);
+                        ImGui::TableHeadersRow();
+                        for (const auto& file : selection_breakdown.LargestFiles()) {
+                            char size_str[32];
+                            FormatByteSize(file.size, size_str, sizeof(size_str));
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn(); ImGui::TextUnformatted(size_str);
+                            ImGui::TableNextColumn(); ImGui::TextUnformatted(file.path.c_str());
+                        }
+                        ImGui::EndTable();
+                    }
+                }
+            }
+            ImGui::End();
+        }
+
+        // Cache statistics window: how much the views share through the directory cache
+        if (show_cache_stats) {
+            ImGui::SetNextWindowSize(ImVec2(420, 200), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Cache Statistics", &show_cache_stats)) {
+                DirectoryCacheStats stats = directory_cache.Stats();
+                unsigned long long lookups = stats.hits + stats.misses;
+                char bytes_str[32], budget_str[32];
+                FormatByteSize(stats.bytes, bytes_str, sizeof(bytes_str));
+                FormatByteSize(stats.budget, budget_str, sizeof(budget_str));
+                ImGui::Text("Listings: %zu cached, %zu in view, %zu unreadable", stats.listings, stats.referenced, stats.failed);
+                ImGui::Text("Hits: %llu | Misses: %llu | Hit rate: %.1f%%", stats.hits, stats.misses,
+                    lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0);
+                ImGui::Text("Evictions: %llu", stats.evictions);
+                ImGui::Text("Folder sizes: %zu known | %llu scans | %llu subtrees reused", stats.folder_sizes, stats.size_scans, stats.size_reused);
+                ImGui::Text("Memory: %s of %s", bytes_str, budget_str);
+                ImGui::ProgressBar(stats.budget ? std::min(1.0f, (float)((double)stats.bytes / (double)stats.budget)) : 0.0f);
+            }
+            ImGui::End();
+        }
+
         // Preferences window
         if (show_preferences) {
             ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
@@ -779,7 +1016,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                 } else if (selected_section == 1) {
                     ImGui::Text("General Settings");
                     ImGui::Separator();
-                    ImGui::Text("(Add general settings here)");
+                    ImGui::Text("Folder size scanning");
+                    ImGui::Checkbox("Measure size on disk", &pref_scan_allocated_sizes);
+                    ImGui::Checkbox("Count hard-linked files once", &pref_scan_dedup_hard_links);
+                    ImGui::Checkbox("Stay on one file system", &pref_scan_one_file_system);
+                    ImGui::Checkbox("Follow symlinks and junctions", &pref_scan_follow_links);
+                    ImGui::Spacing();
+                    ImGui::Text("Directory cache");
+                    ImGui::SliderInt("Memory budget (MB)", &pref_cache_budget_mb, 8, 1024);
                 } else if (selected_section == 2) {
                     ImGui::Text("Appearance Settings");
                     ImGui::Separator();
@@ -804,6 +1048,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                     nlohmann::json cfg;
                     cfg["show_item_checkboxes"] = pref_show_item_checkboxes;
                     cfg["selected_section"] = selected_section;
+                    cfg["scan_allocated_sizes"] = pref_scan_allocated_sizes;
+                    cfg["scan_dedup_hard_links"] = pref_scan_dedup_hard_links;
+                    cfg["scan_one_file_system"] = pref_scan_one_file_system;
+                    cfg["scan_follow_links"] = pref_scan_follow_links;
+                    cfg["cache_budget_mb"] = pref_cache_budget_mb;
                     // write to disk (returns true on success)
                     if (!write_json_file("config.json", cfg)) {
                         // Could log an error or show notification - omitted for brevity
@@ -830,6 +1079,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     }
 
     // Cleanup
+    volume_service.Stop();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
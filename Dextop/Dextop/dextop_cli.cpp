@@ -0,0 +1,523 @@
+// Headless front end: runs the scanning core without GLFW/OpenGL.
+//
+//   dextop scan <path> [--depth N] [--top K] [--format ndjson|json|csv] [scan options]
+//   dextop snapshot <path> -o <file> [scan options]
+//   dextop diff <old-snapshot> <new-snapshot|path> [--top N] [--depth N] [--format text|ndjson|csv]
+//               [--save <file>] [--by-change] [--any-root] [scan options]
+//
+// Every command takes --vfs=memory:... to run against a generated in-memory
+// tree instead of the disk, for benchmarks that do not depend on cache state.
+//
+// scan writes directories as soon as their subtree is complete (children before
+// parents), so output starts immediately and memory stays proportional to the
+// tree depth plus K. diff merge-joins two sorted snapshots in bounded memory.
+
+#include "scanner.hpp"
+#include "scan_breakdown.hpp"
+#include "snapshot.hpp"
+#include "text_output.hpp"
+#include "vfs.hpp"
+#include "vfs_memory.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+enum class OutputFormat { Ndjson, Json, Csv, Text };
+
+struct ScanCommand {
+    std::string path;
+    int depth = -1;     // -1 reports every directory
+    size_t top = 0;     // number of largest files to report
+    OutputFormat format = OutputFormat::Ndjson;
+    ScanOptions options;
+};
+
+struct SnapshotCommand {
+    std::string path;
+    std::string output;
+    ScanOptions options;
+};
+
+struct DiffCommand {
+    std::string old_snapshot;
+    std::string target;      // snapshot file or directory to rescan
+    std::string save;        // where to keep the live rescan, if any
+    DiffOptions diff;
+    OutputFormat format = OutputFormat::Text;
+    ScanOptions options;
+};
+
+void PrintUsage(std::ostream& out) {
+    out << "Usage: dextop scan <path> [--depth N] [--top K] [--format ndjson|json|csv] [scan options]\n"
+           "       dextop snapshot <path> -o <file> [scan options]\n"
+           "       dextop diff <old-snapshot> <new-snapshot|path> [--top N] [--depth N]\n"
+           "                   [--format text|ndjson|csv] [--save <file>] [--by-change] [--any-root]\n"
+           "                   [scan options]\n"
+           "\n"
+           "scan:\n"
+           "  --depth N            report directories up to N levels below <path> (default: all)\n"
+           "  --top K              also report the K largest files (default: 0)\n"
+           "  --format F           ndjson (default), json or csv\n"
+           "snapshot:\n"
+           "  -o, --output FILE    snapshot file to write\n"
+           "diff:\n"
+           "  --top N              changed directories to list, most growth first (default: 20)\n"
+           "  --depth N            only rank directories up to N levels deep (default: all)\n"
+           "  --format F           text (default), ndjson or csv\n"
+           "  --save FILE          when rescanning <path>, keep the new snapshot in FILE\n"
+           "  --by-change          rank by the size of the change, shrinking or growing\n"
+           "  --any-root           compare snapshots taken of different roots\n"
+           "scan options:\n"
+           "  --allocated          also report bytes allocated on disk\n"
+           "  --dedup-hardlinks    count hard-linked files once per (device, inode)\n"
+           "  -x, --one-file-system  do not cross into other filesystems\n"
+           "  --follow-links       follow symlinks/junctions (each directory is entered once)\n"
+           "  --vfs=memory:K=V,..  scan a generated tree mounted at / instead of the disk; keys:\n"
+           "                       depth, dirs, files, max_size, seed, latency_us, error_rate\n";
+}
+
+// Backend selected with --vfs; lives for the whole run
+std::unique_ptr<MemoryVfs> memory_vfs;
+
+// Parses "memory:depth=6,dirs=10,files=10,latency_us=50,error_rate=0.01"
+bool ParseMemoryVfs(const char* spec_text) {
+    if (strncmp(spec_text, "memory:", 7) != 0 && strcmp(spec_text, "memory") != 0) return false;
+    SyntheticTreeSpec spec;
+    long long latency_us = 0;
+    double error_rate = 0;
+    std::string rest = spec_text[6] == ':' ? spec_text + 7 : "";
+    size_t start = 0;
+    while (start < rest.size()) {
+        size_t end = rest.find(',', start);
+        if (end == std::string::npos) end = rest.size();
+        std::string item = rest.substr(start, end - start);
+        start = end + 1;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        const char* value = item.c_str() + eq + 1;
+        char* stop = nullptr;
+        if (key == "error_rate") {
+            error_rate = strtod(value, &stop);
+        } else {
+            unsigned long long number = strtoull(value, &stop, 10);
+            if (key == "depth") spec.depth = (int)number;
+            else if (key == "dirs") spec.dirs_per_dir = (unsigned)number;
+            else if (key == "files") spec.files_per_dir = (unsigned)number;
+            else if (key == "max_size") spec.max_file_size = number;
+            else if (key == "seed") spec.seed = number;
+            else if (key == "latency_us") latency_us = (long long)number;
+            else return false;
+        }
+        if (!stop || *stop != '\0' || stop == value) return false;
+    }
+    memory_vfs = std::make_unique<MemoryVfs>();
+    memory_vfs->MountSynthetic("/", spec);
+    memory_vfs->SetLatency(std::chrono::microseconds(latency_us));
+    memory_vfs->SetErrorRate(error_rate);
+    return true;
+}
+
+// Consumes a scan option shared by all commands. Returns false if arg is not one.
+bool ParseScanOption(const char* arg, ScanOptions& options) {
+    if (strcmp(arg, "--allocated") == 0) options.allocated_sizes = true;
+    else if (strcmp(arg, "--dedup-hardlinks") == 0) options.dedup_hard_links = true;
+    else if (strcmp(arg, "--one-file-system") == 0 || strcmp(arg, "-x") == 0) options.one_file_system = true;
+    else if (strcmp(arg, "--follow-links") == 0) options.follow_links = true;
+    else if (strncmp(arg, "--vfs=", 6) == 0 && ParseMemoryVfs(arg + 6)) options.vfs = memory_vfs.get();
+    else return false;
+    return true;
+}
+
+// Appends the native separator so directory paths follow the scanner's convention
+std::string AsFolderPath(std::string path) {
+    char separator = PathSeparator();
+    if (path.empty() || (path.back() != separator && path.back() != '/')) path += separator;
+    return path;
+}
+
+bool ParseCount(const char* text, long long& value) {
+    char* end = nullptr;
+    value = strtoll(text, &end, 10);
+    return end && *end == '\0' && end != text && value >= 0;
+}
+
+// Returns false (after printing a message) on invalid arguments
+bool ParseScanCommand(int argc, char** argv, ScanCommand& cmd) {
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        long long value = 0;
+        if (strcmp(arg, "--depth") == 0 && has_value) {
+            if (!ParseCount(argv[++i], value)) { std::cerr << "dextop: invalid --depth value\n"; return false; }
+            cmd.depth = (int)value;
+        } else if (strcmp(arg, "--top") == 0 && has_value) {
+            if (!ParseCount(argv[++i], value)) { std::cerr << "dextop: invalid --top value\n"; return false; }
+            cmd.top = (size_t)value;
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            std::string format = argv[++i];
+            if (format == "ndjson") cmd.format = OutputFormat::Ndjson;
+            else if (format == "json") cmd.format = OutputFormat::Json;
+            else if (format == "csv") cmd.format = OutputFormat::Csv;
+            else { std::cerr << "dextop: unknown format '" << format << "'\n"; return false; }
+        } else if (ParseScanOption(arg, cmd.options)) {
+            continue;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            std::cerr << "dextop: unknown or incomplete option '" << arg << "'\n";
+            return false;
+        } else if (cmd.path.empty()) {
+            cmd.path = arg;
+        } else {
+            std::cerr << "dextop: unexpected argument '" << arg << "'\n";
+            return false;
+        }
+    }
+    if (cmd.path.empty()) {
+        std::cerr << "dextop: missing <path>\n";
+        return false;
+    }
+    cmd.path = AsFolderPath(cmd.path);
+    return true;
+}
+
+bool ParseSnapshotCommand(int argc, char** argv, SnapshotCommand& cmd) {
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) && i + 1 < argc) {
+            cmd.output = argv[++i];
+        } else if (ParseScanOption(arg, cmd.options)) {
+            continue;
+        } else if (arg[0] == '-') {
+            std::cerr << "dextop: unknown or incomplete option '" << arg << "'\n";
+            return false;
+        } else if (cmd.path.empty()) {
+            cmd.path = arg;
+        } else {
+            std::cerr << "dextop: unexpected argument '" << arg << "'\n";
+            return false;
+        }
+    }
+    if (cmd.path.empty() || cmd.output.empty()) {
+        std::cerr << "dextop: snapshot needs <path> and -o <file>\n";
+        return false;
+    }
+    cmd.path = AsFolderPath(cmd.path);
+    return true;
+}
+
+bool ParseDiffCommand(int argc, char** argv, DiffCommand& cmd) {
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        long long value = 0;
+        if (strcmp(arg, "--top") == 0 && has_value) {
+            if (!ParseCount(argv[++i], value)) { std::cerr << "dextop: invalid --top value\n"; return false; }
+            cmd.diff.top = (size_t)value;
+        } else if (strcmp(arg, "--depth") == 0 && has_value) {
+            if (!ParseCount(argv[++i], value)) { std::cerr << "dextop: invalid --depth value\n"; return false; }
+            cmd.diff.max_depth = (int)value;
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            std::string format = argv[++i];
+            if (format == "text") cmd.format = OutputFormat::Text;
+            else if (format == "ndjson") cmd.format = OutputFormat::Ndjson;
+            else if (format == "csv") cmd.format = OutputFormat::Csv;
+            else { std::cerr << "dextop: unknown format '" << format << "'\n"; return false; }
+        } else if (strcmp(arg, "--save") == 0 && has_value) {
+            cmd.save = argv[++i];
+        } else if (strcmp(arg, "--by-change") == 0) {
+            cmd.diff.rank = DiffRank::Change;
+        } else if (strcmp(arg, "--any-root") == 0) {
+            cmd.diff.any_root = true;
+        } else if (ParseScanOption(arg, cmd.options)) {
+            continue;
+        } else if (arg[0] == '-') {
+            std::cerr << "dextop: unknown or incomplete option '" << arg << "'\n";
+            return false;
+        } else if (cmd.old_snapshot.empty()) {
+            cmd.old_snapshot = arg;
+        } else if (cmd.target.empty()) {
+            cmd.target = arg;
+        } else {
+            std::cerr << "dextop: unexpected argument '" << arg << "'\n";
+            return false;
+        }
+    }
+    if (cmd.old_snapshot.empty() || cmd.target.empty()) {
+        std::cerr << "dextop: diff needs <old-snapshot> and <new-snapshot|path>\n";
+        return false;
+    }
+    return true;
+}
+
+// Streams directory records, largest files and the summary in the chosen format
+class ScanWriter {
+public:
+    ScanWriter(std::ostream& out, OutputFormat format, bool allocated) : out_(out), format_(format), allocated_(allocated) {}
+
+    void Begin() {
+        begun_ = true;
+        if (format_ == OutputFormat::Json) out_ << "{\n  \"directories\": [";
+        else if (format_ == OutputFormat::Csv) out_ << "record,path,depth,bytes,allocated,files,dirs,errors,hard_links,skipped\n";
+    }
+
+    void Directory(const std::string& path, int depth, const FolderStats& stats) {
+        if (!begun_) Begin();
+        switch (format_) {
+        case OutputFormat::Ndjson:
+            out_ << "{\"type\":\"dir\",\"path\":";
+            WriteJsonString(out_, path);
+            out_ << ",\"depth\":" << depth;
+            WriteStatsJson(stats);
+            out_ << "}\n";
+            break;
+        case OutputFormat::Json:
+            out_ << (first_ ? "\n    {\"path\": " : ",\n    {\"path\": ");
+            WriteJsonString(out_, path);
+            out_ << ", \"depth\": " << depth;
+            WriteStatsJson(stats);
+            out_ << '}';
+            first_ = false;
+            break;
+        case OutputFormat::Csv:
+        case OutputFormat::Text:
+            out_ << "dir,";
+            WriteCsvField(out_, path);
+            out_ << ',' << depth;
+            WriteStatsCsv(stats);
+            break;
+        }
+        // Push the top of the tree out promptly; deeper records ride the stream buffer
+        if (depth <= 1) out_.flush();
+    }
+
+    void End(const std::string& root, const FolderStats& total, const ScanBreakdown& breakdown) {
+        if (!begun_) Begin();
+        std::vector<LargeFile> largest = breakdown.LargestFiles();
+        switch (format_) {
+        case OutputFormat::Ndjson:
+            for (const auto& file : largest) {
+                out_ << "{\"type\":\"file\",\"path\":";
+                WriteJsonString(out_, file.path);
+                out_ << ",\"bytes\":" << file.size << "}\n";
+            }
+            out_ << "{\"type\":\"summary\",\"path\":";
+            WriteJsonString(out_, root);
+            WriteStatsJson(total);
+            out_ << "}\n";
+            break;
+        case OutputFormat::Json:
+            out_ << "\n  ],\n  \"largest_files\": [";
+            first_ = true;
+            for (const auto& file : largest) {
+                out_ << (first_ ? "\n    {\"path\": " : ",\n    {\"path\": ");
+                WriteJsonString(out_, file.path);
+                out_ << ", \"bytes\": " << file.size << '}';
+                first_ = false;
+            }
+            out_ << "\n  ],\n  \"summary\": {\"path\": ";
+            WriteJsonString(out_, root);
+            WriteStatsJson(total);
+            out_ << "}\n}\n";
+            break;
+        case OutputFormat::Csv:
+        case OutputFormat::Text:
+            for (const auto& file : largest) {
+                out_ << "file,";
+                WriteCsvField(out_, file.path);
+                out_ << ",," << file.size << ",,1,0,0,0,0\n";
+            }
+            out_ << "summary,";
+            WriteCsvField(out_, root);
+            out_ << ",0";
+            WriteStatsCsv(total);
+            break;
+        }
+        out_.flush();
+    }
+
+private:
+    void WriteStatsJson(const FolderStats& stats) {
+        const char* sep = (format_ == OutputFormat::Json) ? ", " : ",";
+        const char* colon = (format_ == OutputFormat::Json) ? ": " : ":";
+        out_ << sep << "\"bytes\"" << colon << stats.size;
+        if (allocated_) out_ << sep << "\"allocated\"" << colon << stats.allocated;
+        out_ << sep << "\"files\"" << colon << stats.files
+             << sep << "\"dirs\"" << colon << stats.dirs
+             << sep << "\"errors\"" << colon << stats.errors
+             << sep << "\"hard_links\"" << colon << stats.hard_links
+             << sep << "\"skipped\"" << colon << stats.skipped;
+    }
+
+    // Columns bytes..skipped, including the leading comma and the line break
+    void WriteStatsCsv(const FolderStats& stats) {
+        out_ << ',' << stats.size << ',';
+        if (allocated_) out_ << stats.allocated;
+        out_ << ',' << stats.files << ',' << stats.dirs << ',' << stats.errors
+             << ',' << stats.hard_links << ',' << stats.skipped << '\n';
+    }
+
+    std::ostream& out_;
+    OutputFormat format_;
+    bool allocated_;
+    bool begun_ = false;
+    bool first_ = true;
+};
+
+int RunScan(const ScanCommand& cmd) {
+    ScanOptions options = cmd.options;
+    options.report_depth = cmd.depth;
+    ScanBreakdown breakdown(cmd.top);
+    ScanWriter writer(std::cout, cmd.format, options.allocated_sizes);
+    FolderStats total;
+
+    // The writer emits its header lazily, so nothing is printed if the root cannot be opened
+    bool ok = ScanTree(cmd.path, options, total,
+        [&writer](const std::string& path, int depth, const FolderStats& stats) { writer.Directory(path, depth, stats); },
+        nullptr, cmd.top > 0 ? &breakdown : nullptr);
+    if (!ok) {
+        std::cerr << "dextop: cannot open '" << cmd.path << "'\n";
+        return 1;
+    }
+    writer.End(cmd.path, total, breakdown);
+    return std::cout.good() ? 0 : 1;
+}
+
+int RunSnapshot(const SnapshotCommand& cmd) {
+    FolderStats total;
+    std::string error;
+    if (!WriteSnapshot(cmd.path, cmd.options, cmd.output, total, error)) {
+        std::cerr << "dextop: " << error << "\n";
+        return 1;
+    }
+    std::cerr << "dextop: wrote " << cmd.output << " (" << total.dirs + 1 << " directories, "
+              << total.files << " files, " << total.size << " bytes)\n";
+    return 0;
+}
+
+const char* DeltaStatus(const SnapshotDelta& delta) {
+    if (!delta.in_old) return "added";
+    if (!delta.in_new) return "removed";
+    return delta.Changed() ? "changed" : "unchanged";
+}
+
+// Signed, human readable size change, e.g. "+1.50 GB"
+std::string FormatGrowth(long long growth) {
+    char size_str[32];
+    FormatByteSize((unsigned long long)(growth < 0 ? -growth : growth), size_str, sizeof(size_str));
+    return std::string(growth < 0 ? "-" : "+") + size_str;
+}
+
+void WriteDelta(std::ostream& out, OutputFormat format, const char* record, const SnapshotDelta& delta) {
+    if (format == OutputFormat::Ndjson) {
+        out << "{\"type\":\"" << record << "\",\"path\":";
+        WriteJsonString(out, delta.path);
+        out << ",\"depth\":" << delta.depth << ",\"status\":\"" << DeltaStatus(delta) << "\""
+            << ",\"old_bytes\":" << delta.old_bytes << ",\"new_bytes\":" << delta.new_bytes
+            << ",\"growth\":" << delta.Growth()
+            << ",\"old_files\":" << delta.old_files << ",\"new_files\":" << delta.new_files << "}\n";
+    } else if (format == OutputFormat::Csv) {
+        out << record << ',';
+        WriteCsvField(out, delta.path);
+        out << ',' << delta.depth << ',' << DeltaStatus(delta) << ',' << delta.old_bytes << ',' << delta.new_bytes
+            << ',' << delta.Growth() << ',' << delta.old_files << ',' << delta.new_files << '\n';
+    } else {
+        char old_str[32], new_str[32];
+        FormatByteSize(delta.old_bytes, old_str, sizeof(old_str));
+        FormatByteSize(delta.new_bytes, new_str, sizeof(new_str));
+        char line[128];
+        snprintf(line, sizeof(line), "%14s %14s %14s  %-9s ", FormatGrowth(delta.Growth()).c_str(), old_str, new_str, DeltaStatus(delta));
+        out << line << (delta.path.empty() ? "." : delta.path) << '\n';
+    }
+}
+
+int RunDiff(const DiffCommand& cmd) {
+    std::string new_snapshot = cmd.target;
+    bool temporary = false;
+    std::error_code ec;
+    Vfs& vfs = cmd.options.vfs ? *cmd.options.vfs : NativeVfs();
+    VfsEntry target;
+    if (vfs.Stat(cmd.target, target, 0) && target.is_dir) {
+        // Live comparison: rescan the tree into a snapshot, then diff the two files
+        if (!cmd.save.empty()) {
+            new_snapshot = cmd.save;
+        } else {
+            auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            new_snapshot = (std::filesystem::temp_directory_path(ec) / ("dextop-" + std::to_string(stamp) + ".snap")).string();
+            temporary = true;
+        }
+        FolderStats total;
+        std::string error;
+        if (!WriteSnapshot(AsFolderPath(cmd.target), cmd.options, new_snapshot, total, error)) {
+            std::cerr << "dextop: " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<SnapshotDelta> ranked;
+    SnapshotDelta root;
+    std::string error;
+    bool ok = DiffSnapshots(cmd.old_snapshot, new_snapshot, cmd.diff, ranked, root, error);
+    if (temporary) std::filesystem::remove(new_snapshot, ec);
+    if (!ok) {
+        std::cerr << "dextop: " << error << "\n";
+        return 1;
+    }
+
+    std::ostream& out = std::cout;
+    if (cmd.format == OutputFormat::Csv) {
+        out << "record,path,depth,status,old_bytes,new_bytes,growth,old_files,new_files\n";
+    } else if (cmd.format == OutputFormat::Text) {
+        out << "        Growth            Old            New  Status    Path\n";
+    }
+    for (const auto& delta : ranked) WriteDelta(out, cmd.format, "delta", delta);
+    if (cmd.format == OutputFormat::Text) {
+        out << "Total: " << FormatGrowth(root.Growth()) << ", files " << root.old_files << " -> " << root.new_files << '\n';
+    } else {
+        WriteDelta(out, cmd.format, "summary", root);
+    }
+    out.flush();
+    return out.good() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+    if (argc < 2 || strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
+        PrintUsage(argc < 2 ? std::cerr : std::cout);
+        return argc < 2 ? 2 : 0;
+    }
+    if (strcmp(argv[1], "scan") == 0) {
+        ScanCommand cmd;
+        if (!ParseScanCommand(argc, argv, cmd)) {
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        return RunScan(cmd);
+    }
+    if (strcmp(argv[1], "snapshot") == 0) {
+        SnapshotCommand cmd;
+        if (!ParseSnapshotCommand(argc, argv, cmd)) {
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        return RunSnapshot(cmd);
+    }
+    if (strcmp(argv[1], "diff") == 0) {
+        DiffCommand cmd;
+        if (!ParseDiffCommand(argc, argv, cmd)) {
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        return RunDiff(cmd);
+    }
+    std::cerr << "dextop: unknown command '" << argv[1] << "'\n";
+    PrintUsage(std::cerr);
+    return 2;
+}
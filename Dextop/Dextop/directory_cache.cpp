@@ -0,0 +1,96 @@
+#include "directory_cache.hpp"
+#include <algorithm>
+#include <vector>
+
+DirectoryCache::DirectoryCache(Vfs& vfs, size_t budget_bytes) : vfs_(vfs), budget_(budget_bytes) {}
+
+std::shared_ptr<DirectoryListing> DirectoryCache::Acquire(const std::string& path) {
+    Entry& entry = entries_[path];
+    // A view that drew the listing last frame is still showing it, not acquiring it again
+    const bool showing = entry.listing && entry.last_used + 1 >= frame_;
+    entry.last_used = frame_;
+    if (!entry.listing) {
+        entry.listing = std::make_shared<DirectoryListing>(vfs_);
+        misses_++;
+        Open(entry, path);
+    } else if (entry.failed && std::chrono::steady_clock::now() >= entry.retry_at) {
+        // Reopened in place, so views holding the failed listing pick up the rows
+        misses_++;
+        Open(entry, path);
+    } else if (!showing) {
+        hits_++;
+    }
+    return entry.listing;
+}
+
+void DirectoryCache::Open(Entry& entry, const std::string& path) {
+    entry.failed = !entry.listing->Open(path);
+    if (entry.failed) entry.retry_at = std::chrono::steady_clock::now() + kRetryInterval;
+}
+
+void DirectoryCache::Update() {
+    frame_++;
+    for (auto& item : entries_) {
+        Entry& entry = item.second;
+        // Listings held by a view or used last frame (tree nodes re-acquire every frame)
+        if (entry.listing.use_count() > 1 || entry.last_used + 1 >= frame_) entry.listing->Update();
+    }
+    Trim();
+}
+
+// Drops unused listings, least recently used first, then the totals of folders
+// no cached listing shows, until the estimate fits the budget
+void DirectoryCache::Trim() {
+    size_t bytes = MemoryUsage();
+    if (bytes <= budget_) return;
+
+    std::vector<std::pair<unsigned long long, std::string>> unused;
+    for (const auto& item : entries_) {
+        // Listings used last frame are most likely drawn again in this one
+        if (item.second.listing.use_count() == 1 && item.second.last_used + 1 < frame_) {
+            unused.emplace_back(item.second.last_used, item.first);
+        }
+    }
+    std::sort(unused.begin(), unused.end());
+    for (const auto& victim : unused) {
+        if (bytes <= budget_) break;
+        auto it = entries_.find(victim.second);
+        bytes -= std::min(bytes, it->second.listing->MemoryUsage());
+        entries_.erase(it);
+        evictions_++;
+    }
+
+    if (bytes > budget_) {
+        // Keep the totals shown as rows of a cached listing: the parent of such a folder is cached
+        const char separator = vfs_.Separator();
+        sizes_.Evict([&](const std::string& folder) {
+            if (folder.size() < 2) return false;
+            size_t pos = folder.find_last_of(separator, folder.size() - 2);
+            return pos != std::string::npos && entries_.count(folder.substr(0, pos + 1)) != 0;
+        });
+    }
+}
+
+size_t DirectoryCache::MemoryUsage() const {
+    size_t bytes = sizes_.MemoryUsage();
+    for (const auto& item : entries_) bytes += item.first.capacity() + item.second.listing->MemoryUsage();
+    return bytes;
+}
+
+DirectoryCacheStats DirectoryCache::Stats() const {
+    DirectoryCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    stats.size_scans = sizes_.Scans();
+    stats.size_reused = sizes_.Reused();
+    stats.listings = entries_.size();
+    for (const auto& item : entries_) {
+        if (item.second.listing.use_count() > 1) stats.referenced++;
+        if (item.second.failed) stats.failed++;
+    }
+    stats.folder_sizes = sizes_.Count();
+    stats.bytes = MemoryUsage();
+    stats.budget = budget_;
+    return stats;
+}
@@ -0,0 +1,81 @@
+#ifndef DIRECTORY_CACHE_HPP
+#define DIRECTORY_CACHE_HPP
+
+#include "directory_listing.hpp"
+#include "folder_size_service.hpp"
+#include "vfs.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct DirectoryCacheStats {
+    unsigned long long hits = 0;        // views served a cached listing
+    unsigned long long misses = 0;      // listings enumerated (or failed folders retried)
+    unsigned long long evictions = 0;   // listings dropped to stay within the budget
+    unsigned long long size_scans = 0;  // folder scans started
+    unsigned long long size_reused = 0; // subtrees whose known totals were reused instead of walked
+    size_t listings = 0;                // listings held
+    size_t referenced = 0;              // listings a view holds on to
+    size_t failed = 0;                  // folders that could not be opened, retried after a while
+    size_t folder_sizes = 0;            // folders with known totals
+    size_t bytes = 0;                   // estimated memory of the listings and totals
+    size_t budget = 0;
+};
+
+// Directory listings and folder sizes shared by every view (pane, tab, tree
+// node) of the browser. A view holds the shared_ptr returned by Acquire for as
+// long as it shows the directory, so views on the same directory share one
+// enumeration, one metadata load and one watch, and views on nested
+// directories share the folder scans. Listings no view holds are kept for
+// quick revisits and evicted least recently used first once the estimated
+// memory exceeds the budget.
+class DirectoryCache {
+public:
+    // vfs must outlive the cache
+    explicit DirectoryCache(Vfs& vfs = NativeVfs(), size_t budget_bytes = 64u << 20);
+
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    // Listing of path (ending with a separator), enumerated on first use. Views
+    // that do not hold on to the listing (tree nodes) may call this every frame:
+    // only the first frame of a use counts as a hit. A folder that could not be
+    // opened yields an empty listing, reopened no more than every kRetryInterval.
+    std::shared_ptr<DirectoryListing> Acquire(const std::string& path);
+
+    static constexpr std::chrono::seconds kRetryInterval{2};
+
+    // Recursive folder sizes, shared by all views
+    FolderSizeService& Sizes() { return sizes_; }
+
+    // Call once per frame before drawing: updates each listing in use once,
+    // however many views show it, then evicts down to the budget
+    void Update();
+
+    void SetBudget(size_t bytes) { budget_ = bytes; }
+    DirectoryCacheStats Stats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<DirectoryListing> listing;
+        unsigned long long last_used = 0; // frame of the last Acquire
+        bool failed = false;              // the folder could not be opened
+        std::chrono::steady_clock::time_point retry_at;
+    };
+
+    void Open(Entry& entry, const std::string& path);
+    void Trim();
+    size_t MemoryUsage() const;
+
+    Vfs& vfs_;
+    size_t budget_;
+    unsigned long long frame_ = 0;
+    std::unordered_map<std::string, Entry> entries_;
+    FolderSizeService sizes_;
+    unsigned long long hits_ = 0;
+    unsigned long long misses_ = 0;
+    unsigned long long evictions_ = 0;
+};
+
+#endif // DIRECTORY_CACHE_HPP
@@ -0,0 +1,167 @@
+#include "directory_listing.hpp"
+#include <unordered_map>
+
+DirectoryListing::DirectoryListing(Vfs& vfs) : vfs_(vfs) {}
+
+bool DirectoryListing::Open(const std::string& path) {
+    path_ = path;
+    rows_.clear();
+    pending_ = 0;
+    error_ = 0;
+    visible_.clear();
+    changed_names_.clear();
+    changes_pending_ = false;
+    reread_all_ = false;
+    memory_ = 0;
+    version_++;
+    if (loader_) loader_->Reset(path, kFields);
+    watch_ = vfs_.Watch(path);
+
+    // Names only: the metadata is fetched concurrently below instead of one stat per entry here
+    std::unique_ptr<VfsDirectory> dir = vfs_.OpenDirectory(path, 0);
+    if (!dir) return false;
+    const bool complete = (vfs_.EnumeratedFields() & kFields) == kFields;
+    std::vector<VfsEntry> batch;
+    while (dir->NextBatch(batch, 512)) {
+        for (auto& entry : batch) {
+            ListingRow row;
+            row.entry = std::move(entry);
+            row.has_metadata = complete;
+            rows_.push_back(std::move(row));
+        }
+    }
+    error_ = dir->Error();
+    memory_ = sizeof(*this) + rows_.capacity() * sizeof(ListingRow);
+    for (const auto& row : rows_) memory_ += row.entry.name.capacity();
+    if (!complete && !rows_.empty()) {
+        pending_ = rows_.size();
+        if (!loader_) {
+            loader_ = std::make_unique<MetadataLoader>(vfs_);
+            loader_->Reset(path, kFields);
+        }
+        SubmitPending();
+    }
+    return true;
+}
+
+bool DirectoryListing::Update() {
+    bool changed = false;
+    if (watch_ && watch_->Changed(watch_names_)) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!changes_pending_) first_change_ = now;
+        last_change_ = now;
+        changes_pending_ = true;
+        if (watch_names_.empty()) reread_all_ = true;
+        changed_names_.insert(watch_names_.begin(), watch_names_.end());
+    }
+    if (changes_pending_) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_change_ >= kSettle || now - first_change_ >= kMaxDelay) {
+            Refresh();
+            changed = true;
+        }
+    }
+    if (pending_ == 0) return changed;
+    loader_->Poll(results_);
+    bool loaded = false;
+    for (auto& result : results_) {
+        if (result.index >= rows_.size()) continue;
+        ListingRow& row = rows_[result.index];
+        if ((row.has_metadata && !row.refreshing) || row.entry.name != result.entry.name) continue;
+        // A failed stat (entry deleted meanwhile) keeps the enumeration data
+        if (result.ok) row.entry = std::move(result.entry);
+        row.has_metadata = true;
+        row.refreshing = false;
+        pending_--;
+        loaded = true;
+    }
+    if (loaded) version_++;
+    // All rows are complete: release the loader's threads until the next re-read
+    if (pending_ == 0) loader_.reset();
+    return changed || loaded;
+}
+
+// Re-reads the names and merges them into the rows. Rows still present keep
+// their metadata; new rows and those named by the watch are queued for loading.
+void DirectoryListing::Refresh() {
+    const bool reread_all = reread_all_;
+    std::unordered_set<std::string> changed_names = std::move(changed_names_);
+    changed_names_.clear();
+    changes_pending_ = false;
+    reread_all_ = false;
+
+    std::unique_ptr<VfsDirectory> dir = vfs_.OpenDirectory(path_, 0);
+    if (!dir) {
+        // Deleted or no longer readable: same as opening it afresh
+        Open(path_);
+        return;
+    }
+    const bool complete = (vfs_.EnumeratedFields() & kFields) == kFields;
+    std::unordered_map<std::string, size_t> known;
+    known.reserve(rows_.size());
+    for (size_t i = 0; i < rows_.size(); ++i) known.emplace(rows_[i].entry.name, i);
+
+    std::vector<ListingRow> rows;
+    rows.reserve(rows_.size());
+    std::vector<VfsEntry> batch;
+    while (dir->NextBatch(batch, 512)) {
+        for (auto& entry : batch) {
+            auto it = complete ? known.end() : known.find(entry.name);
+            if (it != known.end() && rows_[it->second].entry.is_dir == entry.is_dir) {
+                ListingRow row = std::move(rows_[it->second]);
+                if (row.has_metadata && (reread_all || changed_names.count(row.entry.name))) row.refreshing = true;
+                rows.push_back(std::move(row));
+                continue;
+            }
+            // New, replaced by another type, or enumerated with its metadata
+            ListingRow row;
+            row.entry = std::move(entry);
+            row.has_metadata = complete;
+            rows.push_back(std::move(row));
+        }
+    }
+    error_ = dir->Error();
+    rows_ = std::move(rows);
+    visible_.clear();
+    version_++;
+
+    memory_ = sizeof(*this) + rows_.capacity() * sizeof(ListingRow);
+    pending_ = 0;
+    for (const auto& row : rows_) {
+        memory_ += row.entry.name.capacity();
+        if (!row.has_metadata || row.refreshing) pending_++;
+    }
+    if (pending_ > 0) {
+        // Row indices changed: drop the requests still queued for the old ones
+        if (!loader_) loader_ = std::make_unique<MetadataLoader>(vfs_);
+        loader_->Reset(path_, kFields);
+        SubmitPending();
+    } else {
+        loader_.reset();
+    }
+}
+
+void DirectoryListing::SetVisibleRows(const std::vector<size_t>& rows) {
+    if (rows == visible_) return;
+    visible_ = rows;
+    if (pending_ > 0) SubmitPending();
+}
+
+
+// Queues every row without metadata: the visible ones first, then the rest in row order
+void DirectoryListing::SubmitPending() {
+    std::vector<MetadataRequest> requests;
+    requests.reserve(pending_);
+    std::vector<bool> queued(rows_.size(), false);
+    auto add = [&](size_t i) {
+        if (i >= rows_.size() || queued[i] || (rows_[i].has_metadata && !rows_[i].refreshing)) return;
+        queued[i] = true;
+        MetadataRequest request;
+        request.index = i;
+        request.name = rows_[i].entry.name;
+        requests.push_back(std::move(request));
+    };
+    for (size_t i : visible_) add(i);
+    for (size_t i = 0; i < rows_.size(); ++i) add(i);
+    loader_->Submit(std::move(requests));
+}
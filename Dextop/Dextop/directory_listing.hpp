@@ -0,0 +1,88 @@
+#ifndef DIRECTORY_LISTING_HPP
+#define DIRECTORY_LISTING_HPP
+
+#include "metadata_loader.hpp"
+#include "vfs.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct ListingRow {
+    VfsEntry entry;
+    bool has_metadata = false; // size, modification time and attributes are valid
+    bool refreshing = false;   // the entry changed; its metadata is shown until re-read
+};
+
+// Contents of one directory for display. Names and types come from a single
+// enumeration; the other columns are filled in progressively by a
+// MetadataLoader as results arrive, rows on screen first. Backends whose
+// enumeration already carries the metadata (Win32) need no extra calls. The
+// loader only exists while metadata is pending, so an idle listing holds no
+// threads and many can be kept in a DirectoryCache. Watch events are merged
+// in once the directory has been quiet briefly: rows still present keep their
+// metadata, and only new rows and the entries the watch names are re-read.
+class DirectoryListing {
+public:
+    explicit DirectoryListing(Vfs& vfs = NativeVfs());
+
+    // Enumerates path and starts loading metadata. Returns false (with no rows)
+    // if the directory cannot be opened.
+    bool Open(const std::string& path);
+    const std::string& Path() const { return path_; }
+    const std::vector<ListingRow>& Rows() const { return rows_; }
+
+    // Applies finished metadata and the changes reported by the watch. Call
+    // once per frame; returns true if any row changed.
+    bool Update();
+
+    // Indices of the rows on screen, in display order; pending loads are
+    // reordered to serve them first
+    void SetVisibleRows(const std::vector<size_t>& rows);
+
+    // Increases whenever the rows change, so views sharing the listing can tell
+    unsigned long long Version() const { return version_; }
+
+    // Non-zero if the enumeration stopped early with an I/O error; the rows
+    // read until then are kept
+    int Error() const { return error_; }
+
+    // Rows still waiting for metadata
+    size_t Pending() const { return pending_; }
+    // Backend of the metadata loader, or "enumeration" when none was needed
+    const char* Backend() const { return loader_ ? loader_->Backend() : "enumeration"; }
+
+    // Rough estimate of the memory held by the rows
+    size_t MemoryUsage() const { return memory_; }
+
+private:
+    void Refresh();
+    void SubmitPending();
+
+    static const unsigned kFields = kVfsSize | kVfsTimes | kVfsAttributes;
+    // Watch events are applied once none arrived for kSettle, or after kMaxDelay
+    // while they keep coming (a file being copied in)
+    static constexpr std::chrono::milliseconds kSettle{200};
+    static constexpr std::chrono::milliseconds kMaxDelay{1000};
+
+    Vfs& vfs_;
+    std::unique_ptr<MetadataLoader> loader_;
+    std::unique_ptr<VfsWatch> watch_;
+    std::string path_;
+    std::vector<ListingRow> rows_;
+    std::vector<MetadataResult> results_;
+    std::vector<std::string> watch_names_;
+    std::unordered_set<std::string> changed_names_; // named by watch events not applied yet
+    bool changes_pending_ = false;
+    bool reread_all_ = false;                       // a watch event named no entry
+    std::chrono::steady_clock::time_point first_change_;
+    std::chrono::steady_clock::time_point last_change_;
+    size_t pending_ = 0;
+    int error_ = 0;
+    std::vector<size_t> visible_;
+    unsigned long long version_ = 0;
+    size_t memory_ = 0;
+};
+
+#endif // DIRECTORY_LISTING_HPP
@@ -0,0 +1,30 @@
+#ifndef FILE_TYPES_HPP
+#define FILE_TYPES_HPP
+
+#include <string>
+
+// Type id used for files without an extension ("file").
+constexpr int kNoExtensionTypeId = 0;
+
+// Type id shared by unknown extensions once kMaxUnknownFileTypes of them are
+// registered ("other").
+constexpr int kOtherTypeId = 1;
+
+// Unknown extensions each get their own id up to this many; the registry is
+// process-wide and never shrinks, so it must not grow with every odd
+// extension found on disk.
+constexpr int kMaxUnknownFileTypes = 256;
+
+// Maps a file extension (without the dot) to a human readable type name.
+// Unknown extensions are returned unchanged.
+std::string GetFileTypeName(const std::string& ext);
+
+// Returns a stable small integer id for the type of the given extension.
+// Extensions sharing a type name (jpg/jpeg) share an id; unknown extensions
+// beyond kMaxUnknownFileTypes share kOtherTypeId. Thread-safe.
+int GetFileTypeId(const std::string& ext);
+
+// Returns the type name registered for an id ("file" for kNoExtensionTypeId).
+std::string GetFileTypeNameById(int id);
+
+#endif // FILE_TYPES_HPP
@@ -0,0 +1,276 @@
+#include "folder_size_service.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+bool SameOptions(const ScanOptions& a, const ScanOptions& b) {
+    return a.allocated_sizes == b.allocated_sizes && a.dedup_hard_links == b.dedup_hard_links &&
+           a.one_file_system == b.one_file_system && a.follow_links == b.follow_links && a.vfs == b.vfs;
+}
+
+} // namespace
+
+FolderSizeService::FolderSizeService(unsigned threads) {
+    for (unsigned i = 0; i < std::max(threads, 1u); ++i) threads_.emplace_back(&FolderSizeService::Run, this);
+}
+
+FolderSizeService::~FolderSizeService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& job : running_) job->feed.cancel = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+void FolderSizeService::SetOptions(const ScanOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (SameOptions(options_, options)) return;
+    options_ = options;
+    ClearLocked();
+    // Walk what the views still show with the new options
+    QueueLocked();
+    wake_cv_.notify_all();
+}
+
+void FolderSizeService::Request(const std::vector<std::string>& folders) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requested_ = folders;
+        std::unordered_set<std::string> wanted(folders.begin(), folders.end());
+        wanted.insert(focused_.begin(), focused_.end());
+        for (auto& job : running_) {
+            if (!wanted.count(job->folder)) job->feed.cancel = true;
+        }
+        QueueLocked();
+    }
+    wake_cv_.notify_all();
+}
+
+void FolderSizeService::Focus(const std::vector<std::string>& folders, bool breakdown) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (folders == focused_ && breakdown == focus_breakdown_) return;
+        focused_ = folders;
+        focus_breakdown_ = breakdown;
+        std::unordered_set<std::string> focused(folders.begin(), folders.end());
+        for (auto it = breakdowns_.begin(); it != breakdowns_.end();) {
+            if (focused.count(it->first)) ++it;
+            else it = breakdowns_.erase(it);
+        }
+        std::unordered_set<std::string> wanted(requested_.begin(), requested_.end());
+        wanted.insert(focused.begin(), focused.end());
+        for (auto& job : running_) {
+            // Restart a plain walk of a folder that now wants its breakdown, rather than walk it twice
+            if (!wanted.count(job->folder) || (!job->breakdown && WantsBreakdownLocked(job->folder))) job->feed.cancel = true;
+        }
+        QueueLocked();
+    }
+    wake_cv_.notify_all();
+}
+
+// Focused folders first, then the requested ones, each only if it needs a walk
+void FolderSizeService::QueueLocked() {
+    queue_.clear();
+    for (const auto& folder : focused_) {
+        if (NeedsScanLocked(folder)) queue_.push_back(folder);
+    }
+    for (const auto& folder : requested_) {
+        if (NeedsScanLocked(folder)) queue_.push_back(folder);
+    }
+}
+
+bool FolderSizeService::NeedsScanLocked(const std::string& folder) const {
+    if (RunningLocked(folder)) return false;
+    auto it = sizes_.find(folder);
+    if (it == sizes_.end() || it->second.state == FolderSizeState::Unknown) return true;
+    return WantsBreakdownLocked(folder) && !breakdowns_.count(folder);
+}
+
+bool FolderSizeService::WantsBreakdownLocked(const std::string& folder) const {
+    return focus_breakdown_ && std::find(focused_.begin(), focused_.end(), folder) != focused_.end();
+}
+
+// The scan of folder that is not being cancelled, if any
+const FolderSizeService::Job* FolderSizeService::RunningLocked(const std::string& folder) const {
+    for (const auto& job : running_) {
+        if (job->folder == folder && !job->feed.cancel) return job.get();
+    }
+    return nullptr;
+}
+
+void FolderSizeService::Evict(const std::function<bool(const std::string& folder)>& keep) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = sizes_.begin(); it != sizes_.end();) {
+        const bool focused = std::find(focused_.begin(), focused_.end(), it->first) != focused_.end();
+        if (it->second.state == FolderSizeState::Running || focused || keep(it->first)) {
+            ++it;
+        } else {
+            key_bytes_ -= it->first.size();
+            it = sizes_.erase(it);
+        }
+    }
+}
+
+size_t FolderSizeService::Count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sizes_.size();
+}
+
+size_t FolderSizeService::MemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Node, bucket and string header per entry, plus the path characters
+    return sizes_.size() * (sizeof(std::pair<const std::string, FolderSize>) + 2 * sizeof(void*)) + key_bytes_;
+}
+
+FolderSize FolderSizeService::Lookup(const std::string& folder) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sizes_.find(folder);
+    return it != sizes_.end() ? it->second : FolderSize();
+}
+
+ScanProgress FolderSizeService::Progress(const std::string& folder) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ScanProgress progress;
+    auto it = sizes_.find(folder);
+    const FolderSizeState state = it != sizes_.end() ? it->second.state : FolderSizeState::Unknown;
+    if (state == FolderSizeState::Running) {
+        if (const Job* job = RunningLocked(folder)) {
+            progress = job->feed.Sample();
+            // Picked up, but the walk has not published yet
+            if (progress.state == ScanState::Idle) progress.state = ScanState::Running;
+        }
+        return progress;
+    }
+    if (state == FolderSizeState::Done || state == FolderSizeState::Error) {
+        progress.stats = it->second.stats;
+        progress.state = state == FolderSizeState::Done ? ScanState::Done : ScanState::Error;
+        progress.fraction = 1.0;
+        progress.eta_seconds = 0.0;
+    }
+    return progress;
+}
+
+std::shared_ptr<const ScanBreakdown> FolderSizeService::Breakdown(const std::string& folder) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = breakdowns_.find(folder);
+    return it != breakdowns_.end() ? it->second : nullptr;
+}
+
+void FolderSizeService::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClearLocked();
+}
+
+void FolderSizeService::ClearLocked() {
+    for (auto& job : running_) job->feed.cancel = true;
+    queue_.clear();
+    sizes_.clear();
+    breakdowns_.clear();
+    key_bytes_ = 0;
+    epoch_++;
+    generation_++;
+}
+
+FolderSize& FolderSizeService::EntryLocked(const std::string& folder) {
+    auto inserted = sizes_.try_emplace(folder);
+    if (inserted.second) key_bytes_ += folder.size();
+    return inserted.first->second;
+}
+
+void FolderSizeService::Run() {
+    for (;;) {
+        auto job = std::make_shared<Job>();
+        ScanOptions options;
+        unsigned long long epoch = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            job->folder = std::move(queue_.front());
+            queue_.pop_front();
+            // Finished or picked up by another thread since it was queued
+            if (!NeedsScanLocked(job->folder)) continue;
+            job->breakdown = WantsBreakdownLocked(job->folder);
+            FolderSize& size = EntryLocked(job->folder);
+            // A known folder walked again for its breakdown keeps showing its total meanwhile
+            if (size.state != FolderSizeState::Done) {
+                size.state = FolderSizeState::Running;
+                size.stats = FolderStats();
+            }
+            running_.push_back(job);
+            scans_++;
+            options = options_;
+            epoch = epoch_;
+        }
+
+        // Everything below touches sizes_ only for the epoch the scan started in
+        options.report_depth = 1;
+        // With hard links counted once, or links followed to directories entered
+        // once, what a subtree adds depends on what the scan met before it, so a
+        // subtree total is only valid within the scan that produced it
+        const bool independent = !options.dedup_hard_links && !options.follow_links;
+        // Reused subtrees would be missing from the breakdown
+        if (independent && !job->breakdown) {
+            options.known_subtree = [&](const std::string& path, FolderStats& stats) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = sizes_.find(path);
+                if (epoch != epoch_ || it == sizes_.end() || it->second.state != FolderSizeState::Done) return false;
+                stats = it->second.stats;
+                reused_++;
+                return true;
+            };
+        }
+        options.on_progress = [&](const FolderStats& so_far, const std::string&, double) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (epoch != epoch_ || job->feed.cancel) return;
+            FolderSize& size = EntryLocked(job->folder);
+            if (size.state != FolderSizeState::Running) return;
+            size.stats = so_far;
+            generation_++;
+        };
+        // Immediate subfolders are complete when reported, keep them for later visits
+        auto on_directory = [&](const std::string& path, int depth, const FolderStats& stats) {
+            if (depth != 1 || !independent) return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (epoch != epoch_) return;
+            FolderSize& size = EntryLocked(path);
+            if (size.state == FolderSizeState::Done) return;
+            // A scan of this subfolder on another thread finishes on its own
+            if (size.state == FolderSizeState::Running) return;
+            size.stats = stats;
+            size.state = FolderSizeState::Done;
+        };
+
+        FolderStats total;
+        auto breakdown = job->breakdown ? std::make_shared<ScanBreakdown>() : nullptr;
+        bool ok = job->feed.Scan(job->folder, options, total, breakdown.get(), on_directory);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.erase(std::remove(running_.begin(), running_.end(), job), running_.end());
+        if (epoch != epoch_) continue;
+        if (job->feed.cancel) {
+            // Unless another thread has taken the folder over, forget the partial totals
+            auto it = sizes_.find(job->folder);
+            if (it != sizes_.end() && it->second.state == FolderSizeState::Running && !RunningLocked(job->folder)) {
+                key_bytes_ -= job->folder.size();
+                sizes_.erase(it);
+            }
+            // Cancelled to be restarted with a breakdown, or focused again meanwhile
+            if (!stopping_ && NeedsScanLocked(job->folder) &&
+                (std::find(focused_.begin(), focused_.end(), job->folder) != focused_.end() ||
+                 std::find(requested_.begin(), requested_.end(), job->folder) != requested_.end())) {
+                queue_.push_front(job->folder);
+                wake_cv_.notify_one();
+            }
+        } else {
+            FolderSize& size = EntryLocked(job->folder);
+            size.stats = total;
+            size.state = ok ? FolderSizeState::Done : FolderSizeState::Error;
+            if (breakdown && WantsBreakdownLocked(job->folder)) breakdowns_[job->folder] = std::move(breakdown);
+        }
+        generation_++;
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef FOLDER_SIZE_SERVICE_HPP
+#define FOLDER_SIZE_SERVICE_HPP
+
+#include "scan_breakdown.hpp"
+#include "scan_progress.hpp"
+#include "scanner.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class FolderSizeState {
+    Unknown, // not scanned (or scan cancelled)
+    Running, // stats hold the partial totals gathered so far
+    Done,
+    Error    // the folder could not be opened
+};
+
+struct FolderSize {
+    FolderStats stats;
+    FolderSizeState state = FolderSizeState::Unknown;
+};
+
+// Computes the recursive size of many folders on a few background threads,
+// in the order the caller asks for them (on-screen rows first). Finished
+// totals are kept and reused: a scan takes the totals of subfolders that are
+// already known instead of walking them again, and records the totals of the
+// immediate subfolders it walks, so opening one of them later is instant.
+// Neither is done when hard links are deduplicated or links followed, since a
+// subtree's share then depends on the rest of the scan. Running scans publish
+// partial totals as they go. Folders the user picked (selected or checked) are
+// focused: scanned first, with live progress and on request a per-type
+// breakdown, so every view of a folder shares one walk of it.
+class FolderSizeService {
+public:
+    explicit FolderSizeService(unsigned threads = 2);
+    ~FolderSizeService();
+
+    FolderSizeService(const FolderSizeService&) = delete;
+    FolderSizeService& operator=(const FolderSizeService&) = delete;
+
+    // Options for new scans. Known totals are dropped when the options change.
+    void SetOptions(const ScanOptions& options);
+
+    // Replaces the queue with these folders (ending with a separator), scanned in
+    // this order after the focused ones. Known folders are skipped; scans of
+    // folders no longer requested or focused are cancelled.
+    void Request(const std::vector<std::string>& folders);
+
+    // Replaces the focused folders, which are scanned ahead of the requested
+    // ones. With breakdown set their walks also fill a per-type breakdown;
+    // such a walk cannot reuse known subtrees, so a focused folder already
+    // known is walked once more for it. Cheap when nothing changed.
+    void Focus(const std::vector<std::string>& folders, bool breakdown);
+
+    FolderSize Lookup(const std::string& folder) const;
+
+    // Rate, ETA and current directory while folder is being walked, the totals
+    // once it is known; Idle if neither
+    ScanProgress Progress(const std::string& folder) const;
+
+    // Breakdown of a focused folder, null until its walk has finished
+    std::shared_ptr<const ScanBreakdown> Breakdown(const std::string& folder) const;
+
+    // Forgets all totals and cancels running scans
+    void Clear();
+
+    // Increases whenever any total changes, so callers only re-sort when needed
+    unsigned long long Generation() const { return generation_; }
+
+    // Drops the kept totals of folders keep() rejects. Running scans and focused
+    // folders are left alone.
+    void Evict(const std::function<bool(const std::string& folder)>& keep);
+
+    // Folders with kept totals, and a rough estimate of their memory
+    size_t Count() const;
+    size_t MemoryUsage() const;
+
+    // Scans started, and subtrees whose known totals were reused instead of walked
+    unsigned long long Scans() const { return scans_; }
+    unsigned long long Reused() const { return reused_; }
+
+private:
+    struct Job {
+        std::string folder;
+        bool breakdown = false;
+        ScanProgressFeed feed; // cancel flag and live progress
+    };
+
+    void Run();
+    void ClearLocked();
+    void QueueLocked();
+    bool NeedsScanLocked(const std::string& folder) const;
+    bool WantsBreakdownLocked(const std::string& folder) const;
+    const Job* RunningLocked(const std::string& folder) const;
+    FolderSize& EntryLocked(const std::string& folder);
+
+    std::vector<std::thread> threads_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    bool stopping_ = false;
+    ScanOptions options_;
+    unsigned long long epoch_ = 0; // bumped on Clear so results of older scans are dropped
+    std::unordered_map<std::string, FolderSize> sizes_;
+    std::unordered_map<std::string, std::shared_ptr<const ScanBreakdown>> breakdowns_; // focused folders only
+    std::vector<std::string> requested_;
+    std::vector<std::string> focused_;
+    bool focus_breakdown_ = false;
+    std::deque<std::string> queue_;
+    std::vector<std::shared_ptr<Job>> running_;
+    std::atomic<unsigned long long> generation_{0};
+    std::atomic<unsigned long long> scans_{0};
+    std::atomic<unsigned long long> reused_{0};
+    size_t key_bytes_ = 0; // total length of the keys of sizes_
+};
+
+#endif // FOLDER_SIZE_SERVICE_HPP
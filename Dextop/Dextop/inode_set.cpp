@@ -0,0 +1,66 @@
+#include "inode_set.hpp"
+
+namespace {
+
+// splitmix64 finalizer; spreads sequential inode numbers over all shards and slots
+unsigned long long HashKey(unsigned long long device, unsigned long long inode) {
+    unsigned long long x = inode ^ (device * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+bool InodeSet::Insert(unsigned long long device, unsigned long long inode) {
+    const unsigned long long hash = HashKey(device, inode);
+    Shard& shard = shards_[hash >> (64 - kShardBits)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (device == 0 && inode == 0) {
+        if (shard.has_zero_key) return false;
+        shard.has_zero_key = true;
+        shard.count++;
+        return true;
+    }
+    // Grow at 70% load, rehashing the existing keys
+    if ((shard.count + 1) * 10 > shard.slots.size() * 7) {
+        std::vector<Key> old;
+        old.swap(shard.slots);
+        shard.slots.assign(old.empty() ? 64 : old.size() * 2, Key{ 0, 0 });
+        const size_t mask = shard.slots.size() - 1;
+        for (const Key& key : old) {
+            if (key.device == 0 && key.inode == 0) continue;
+            size_t i = HashKey(key.device, key.inode) & mask;
+            while (shard.slots[i].device != 0 || shard.slots[i].inode != 0) i = (i + 1) & mask;
+            shard.slots[i] = key;
+        }
+    }
+    const size_t mask = shard.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Key& slot = shard.slots[i];
+        if (slot.device == device && slot.inode == inode) return false;
+        if (slot.device == 0 && slot.inode == 0) {
+            slot = Key{ device, inode };
+            shard.count++;
+            return true;
+        }
+    }
+}
+
+size_t InodeSet::Size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.count;
+    }
+    return total;
+}
+
+void InodeSet::Clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::vector<Key>().swap(shard.slots);
+        shard.count = 0;
+        shard.has_zero_key = false;
+    }
+}
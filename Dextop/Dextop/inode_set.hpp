@@ -0,0 +1,41 @@
+#ifndef INODE_SET_HPP
+#define INODE_SET_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Concurrent set of (device, inode) pairs, used to count hard-linked files once.
+// Keys live in sharded open-addressing tables (16 bytes per entry, no per-node
+// allocation); each shard has its own lock so parallel scans rarely contend.
+class InodeSet {
+public:
+    InodeSet() = default;
+    InodeSet(const InodeSet&) = delete;
+    InodeSet& operator=(const InodeSet&) = delete;
+
+    // Returns true if the pair was not in the set yet.
+    bool Insert(unsigned long long device, unsigned long long inode);
+
+    size_t Size() const;
+    void Clear();
+
+private:
+    struct Key {
+        unsigned long long device;
+        unsigned long long inode;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<Key> slots; // power-of-two size; {0, 0} marks an empty slot
+        size_t count = 0;
+        bool has_zero_key = false;
+    };
+
+    static constexpr size_t kShardBits = 6;
+    static constexpr size_t kShardCount = size_t(1) << kShardBits;
+
+    Shard shards_[kShardCount];
+};
+
+#endif // INODE_SET_HPP
@@ -0,0 +1,347 @@
+#include "metadata_loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define DEXTOP_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef DEXTOP_HAVE_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#ifdef DEXTOP_HAVE_IO_URING
+
+namespace {
+
+const unsigned kRingEntries = 256;
+
+unsigned StatxMask(unsigned fields) {
+    unsigned mask = STATX_TYPE | STATX_MODE;
+    if (fields & kVfsSize) mask |= STATX_SIZE;
+    if (fields & kVfsAllocated) mask |= STATX_BLOCKS;
+    if (fields & (kVfsFileIds | kVfsDirIds)) mask |= STATX_INO | STATX_NLINK;
+    if (fields & kVfsTimes) mask |= STATX_MTIME;
+    return mask;
+}
+
+// Same mapping as the POSIX backend's stat()
+void FillFromStatx(const struct statx& st, VfsEntry& entry) {
+    entry.is_dir = S_ISDIR(st.stx_mode);
+    entry.is_link = S_ISLNK(st.stx_mode);
+    entry.size = entry.is_dir ? 0 : (unsigned long long)st.stx_size;
+    entry.allocated = entry.is_dir ? 0 : (unsigned long long)st.stx_blocks * 512;
+    entry.modified = (long long)st.stx_mtime.tv_sec;
+    entry.attributes = (unsigned)st.stx_mode;
+    entry.has_id = true;
+    entry.device = (unsigned long long)makedev(st.stx_dev_major, st.stx_dev_minor);
+    entry.inode = (unsigned long long)st.stx_ino;
+    entry.links = (unsigned long long)st.stx_nlink;
+}
+
+} // namespace
+
+// Minimal io_uring: the submission and completion rings mapped from the kernel,
+// plus one slot per ring entry holding what an in-flight statx points to
+struct MetadataLoader::Ring {
+    struct Slot {
+        struct statx st;
+        MetadataRequest request;
+        std::shared_ptr<Target> target;
+    };
+
+    int fd = -1;
+    void* sq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    void* cq_ring = MAP_FAILED;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+    size_t sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    std::vector<Slot> slots;
+    std::vector<unsigned> free_slots;
+
+    bool Init(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) return false;
+        if (!SupportsStatx()) return false;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) return false;
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ring = sq_ring;
+        } else {
+            cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) return false;
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe*)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = (char*)sq_ring;
+        char* cq = (char*)cq_ring;
+        sq_tail = (unsigned*)(sq + params.sq_off.tail);
+        sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+        sq_array = (unsigned*)(sq + params.sq_off.array);
+        cq_head = (unsigned*)(cq + params.cq_off.head);
+        cq_tail = (unsigned*)(cq + params.cq_off.tail);
+        cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+        slots.resize(params.sq_entries);
+        for (unsigned i = params.sq_entries; i > 0; --i) free_slots.push_back(i - 1);
+        return true;
+    }
+
+    // IORING_OP_STATX needs Linux 5.6; older kernels fail the probe or lack the opcode
+    bool SupportsStatx() {
+        const size_t size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<unsigned char> buffer(size, 0);
+        io_uring_probe* probe = (io_uring_probe*)buffer.data();
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+        return probe->last_op >= IORING_OP_STATX && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    void Prepare(unsigned slot_index) {
+        Slot& slot = slots[slot_index];
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = slot.target->fd;
+        sqe->addr = (unsigned long long)(uintptr_t)slot.request.name.c_str();
+        sqe->len = StatxMask(slot.target->fields);
+        sqe->off = (unsigned long long)(uintptr_t)&slot.st;
+        sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+        sqe->user_data = slot_index;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Submits `submit` prepared entries and waits for at least `wait` completions
+    bool Enter(unsigned submit, unsigned wait) {
+        for (;;) {
+            long ret = syscall(__NR_io_uring_enter, fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (ret >= 0) return true;
+            if (errno != EINTR) return false;
+        }
+    }
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+        if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+        if (fd >= 0) close(fd);
+    }
+};
+
+#else
+
+struct MetadataLoader::Ring {};
+
+#endif // DEXTOP_HAVE_IO_URING
+
+MetadataLoader::Target::~Target() {
+#ifndef _WIN32
+    if (fd >= 0) close(fd);
+#endif
+}
+
+MetadataLoader::MetadataLoader(Vfs& vfs, unsigned threads, bool use_io_uring) : vfs_(vfs) {
+#ifdef DEXTOP_HAVE_IO_URING
+    // statx by name relative to a directory fd only makes sense for the real filesystem
+    if (use_io_uring && &vfs == &NativeVfs()) {
+        ring_ = std::make_unique<Ring>();
+        if (!ring_->Init(kRingEntries)) ring_.reset();
+    }
+#else
+    (void)use_io_uring;
+#endif
+    if (ring_) {
+        threads_.emplace_back(&MetadataLoader::RunRing, this);
+    } else {
+        for (unsigned i = 0; i < std::max(threads, 1u); ++i) threads_.emplace_back(&MetadataLoader::RunThread, this);
+    }
+}
+
+MetadataLoader::~MetadataLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    wake_cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+void MetadataLoader::Reset(const std::string& directory, unsigned fields) {
+    auto target = std::make_shared<Target>();
+    target->directory = directory;
+    const char separator = vfs_.Separator();
+    if (!directory.empty() && directory.back() != separator && directory.back() != '/') target->directory += separator;
+    target->fields = fields;
+    std::lock_guard<std::mutex> lock(mutex_);
+    target_ = std::move(target);
+    queue_.clear();
+    results_.clear();
+}
+
+void MetadataLoader::Submit(std::vector<MetadataRequest> requests) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.assign(std::make_move_iterator(requests.begin()), std::make_move_iterator(requests.end()));
+    }
+    wake_cv_.notify_all();
+}
+
+void MetadataLoader::Poll(std::vector<MetadataResult>& results) {
+    results.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    results.swap(results_);
+}
+
+bool MetadataLoader::Busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !queue_.empty() || in_flight_ > 0;
+}
+
+const char* MetadataLoader::Backend() const {
+    return ring_ ? "io_uring" : "threads";
+}
+
+void MetadataLoader::Finish(const Target& target, MetadataResult&& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_--;
+    // Results for a directory the caller has moved away from are dropped
+    if (&target == target_.get()) results_.push_back(std::move(result));
+}
+
+void MetadataLoader::RunThread() {
+    for (;;) {
+        MetadataRequest request;
+        std::shared_ptr<Target> target;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            request = std::move(queue_.front());
+            queue_.pop_front();
+            target = target_;
+            in_flight_++;
+        }
+        MetadataResult result;
+        result.index = request.index;
+        result.ok = vfs_.Stat(target->directory + request.name, result.entry, target->fields, false);
+        result.entry.name = std::move(request.name);
+        Finish(*target, std::move(result));
+    }
+}
+
+void MetadataLoader::RunRing() {
+#ifdef DEXTOP_HAVE_IO_URING
+    Ring& ring = *ring_;
+    size_t in_ring = 0;
+    std::vector<MetadataRequest> batch;
+    for (;;) {
+        std::shared_ptr<Target> target;
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (in_ring == 0) wake_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            // Requests already handed to the kernel point into the slots, so drain before leaving
+            if (stopping_ && in_ring == 0) return;
+            if (!stopping_) {
+                while (!queue_.empty() && batch.size() < ring.free_slots.size()) {
+                    batch.push_back(std::move(queue_.front()));
+                    queue_.pop_front();
+                }
+                target = target_;
+                in_flight_ += batch.size();
+            }
+        }
+
+        unsigned submit = 0;
+        if (!batch.empty()) {
+            if (target->fd < 0) {
+                target->fd = open(target->directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            }
+            for (auto& request : batch) {
+                if (target->fd < 0) {
+                    MetadataResult result;
+                    result.index = request.index;
+                    result.entry.name = std::move(request.name);
+                    Finish(*target, std::move(result));
+                    continue;
+                }
+                unsigned slot_index = ring.free_slots.back();
+                ring.free_slots.pop_back();
+                Ring::Slot& slot = ring.slots[slot_index];
+                slot.request = std::move(request);
+                slot.target = target;
+                ring.Prepare(slot_index);
+                submit++;
+            }
+        }
+        in_ring += submit;
+        if (in_ring == 0) continue;
+
+        if (!ring.Enter(submit, 1)) {
+            // The ring is unusable; answer everything in it with a plain stat instead
+            for (auto& slot : ring.slots) {
+                if (!slot.target) continue;
+                MetadataResult result;
+                result.index = slot.request.index;
+                result.ok = vfs_.Stat(slot.target->directory + slot.request.name, result.entry, slot.target->fields, false);
+                result.entry.name = std::move(slot.request.name);
+                Finish(*slot.target, std::move(result));
+                slot.target.reset();
+            }
+            in_ring = 0;
+            ring.free_slots.clear();
+            for (unsigned i = (unsigned)ring.slots.size(); i > 0; --i) ring.free_slots.push_back(i - 1);
+            continue;
+        }
+
+        unsigned head = *ring.cq_head;
+        const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = ring.cqes[head & *ring.cq_mask];
+            unsigned slot_index = (unsigned)cqe.user_data;
+            Ring::Slot& slot = ring.slots[slot_index];
+            MetadataResult result;
+            result.index = slot.request.index;
+            result.ok = (cqe.res == 0);
+            if (result.ok) FillFromStatx(slot.st, result.entry);
+            result.entry.name = std::move(slot.request.name);
+            std::shared_ptr<Target> done_target = std::move(slot.target);
+            Finish(*done_target, std::move(result));
+            ring.free_slots.push_back(slot_index);
+            in_ring--;
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+#endif
+}
@@ -0,0 +1,85 @@
+#ifndef METADATA_LOADER_HPP
+#define METADATA_LOADER_HPP
+
+#include "vfs.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One entry of the current directory whose metadata is wanted. index is the
+// caller's row number and is handed back with the result.
+struct MetadataRequest {
+    size_t index = 0;
+    std::string name;
+};
+
+struct MetadataResult {
+    size_t index = 0;
+    bool ok = false;
+    VfsEntry entry;
+};
+
+// Fetches metadata for many entries of one directory concurrently, so a listing
+// does not pay one blocking stat round trip per row. On Linux with the native
+// VFS the requests are submitted as statx operations through io_uring, keeping
+// up to a full ring in flight from a single thread; elsewhere, or when the
+// kernel refuses io_uring, a small thread pool calls Vfs::Stat. Requests are
+// served in the order given, so callers put visible rows first.
+class MetadataLoader {
+public:
+    // vfs must outlive the loader. threads sizes the fallback pool; use_io_uring
+    // false forces the pool (for comparisons).
+    explicit MetadataLoader(Vfs& vfs = NativeVfs(), unsigned threads = 16, bool use_io_uring = true);
+    ~MetadataLoader();
+
+    MetadataLoader(const MetadataLoader&) = delete;
+    MetadataLoader& operator=(const MetadataLoader&) = delete;
+
+    // Switches to another directory: drops queued requests and discards the
+    // results of requests still in flight.
+    void Reset(const std::string& directory, unsigned fields);
+
+    // Replaces the queued (not yet started) requests with these, in this order
+    void Submit(std::vector<MetadataRequest> requests);
+
+    // Moves the results finished since the previous call into results
+    void Poll(std::vector<MetadataResult>& results);
+
+    // True while requests are queued or in flight
+    bool Busy() const;
+
+    // "io_uring" or "threads"
+    const char* Backend() const;
+
+    // Shared by the queue and the workers
+    struct Target {
+        std::string directory;
+        unsigned fields = 0;
+        int fd = -1; // opened lazily by the io_uring worker
+        ~Target();
+    };
+    struct Ring;
+
+private:
+    void RunThread();
+    void RunRing();
+    void Finish(const Target& target, MetadataResult&& result);
+
+    Vfs& vfs_;
+    std::unique_ptr<Ring> ring_;
+    std::vector<std::thread> threads_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    bool stopping_ = false;
+    std::shared_ptr<Target> target_;
+    std::deque<MetadataRequest> queue_;
+    std::vector<MetadataResult> results_;
+    size_t in_flight_ = 0;
+};
+
+#endif // METADATA_LOADER_HPP
@@ -0,0 +1,116 @@
+#include "scan_breakdown.hpp"
+#include "file_types.hpp"
+#include "text_output.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+bool LargerFirst(const LargeFile& a, const LargeFile& b) {
+    return a.size > b.size;
+}
+
+} // namespace
+
+ScanBreakdown::ScanBreakdown(size_t top_n) : top_n_(top_n) {}
+
+void ScanBreakdown::AddFile(const std::string& folder, const char* name, unsigned long long size) {
+    int type_id = kNoExtensionTypeId;
+    const char* ext = strrchr(name, '.');
+    if (ext && ext != name && ext[1] != '\0') {
+        auto it = type_id_cache_.find(ext + 1);
+        if (it == type_id_cache_.end()) {
+            it = type_id_cache_.emplace(ext + 1, GetFileTypeId(ext + 1)).first;
+        }
+        type_id = it->second;
+    }
+    if ((size_t)type_id >= types_.size()) types_.resize(type_id + 1);
+    types_[type_id].bytes += size;
+    types_[type_id].files++;
+    total_bytes_ += size;
+    total_files_++;
+    OfferLargeFile(size, folder, name);
+}
+
+void ScanBreakdown::OfferLargeFile(unsigned long long size, const std::string& folder, const char* name) {
+    if (top_n_ == 0) return;
+    // Only build the path string for files that actually enter the heap
+    if (largest_.size() == top_n_) {
+        if (size <= largest_.front().size) return;
+        std::pop_heap(largest_.begin(), largest_.end(), LargerFirst);
+        largest_.back().size = size;
+        largest_.back().path.assign(folder).append(name);
+    } else {
+        largest_.push_back(LargeFile{ size, folder + name });
+    }
+    std::push_heap(largest_.begin(), largest_.end(), LargerFirst);
+}
+
+void ScanBreakdown::Merge(const ScanBreakdown& other) {
+    if (other.types_.size() > types_.size()) types_.resize(other.types_.size());
+    for (size_t i = 0; i < other.types_.size(); ++i) {
+        types_[i].bytes += other.types_[i].bytes;
+        types_[i].files += other.types_[i].files;
+    }
+    total_bytes_ += other.total_bytes_;
+    total_files_ += other.total_files_;
+    for (const auto& file : other.largest_) {
+        if (top_n_ == 0) break;
+        if (largest_.size() == top_n_) {
+            if (file.size <= largest_.front().size) continue;
+            std::pop_heap(largest_.begin(), largest_.end(), LargerFirst);
+            largest_.back() = file;
+        } else {
+            largest_.push_back(file);
+        }
+        std::push_heap(largest_.begin(), largest_.end(), LargerFirst);
+    }
+}
+
+std::vector<LargeFile> ScanBreakdown::LargestFiles() const {
+    std::vector<LargeFile> sorted = largest_;
+    std::sort(sorted.begin(), sorted.end(), LargerFirst);
+    return sorted;
+}
+
+bool WriteBreakdownCsv(const ScanBreakdown& breakdown, std::ostream& out) {
+    out << "section,type,files,bytes,path\n";
+    const auto& types = breakdown.Types();
+    for (size_t id = 0; id < types.size(); ++id) {
+        if (types[id].files == 0) continue;
+        out << "type,";
+        WriteCsvField(out, GetFileTypeNameById((int)id));
+        out << ',' << types[id].files << ',' << types[id].bytes << ",\n";
+    }
+    for (const auto& file : breakdown.LargestFiles()) {
+        out << "largest,,1," << file.size << ',';
+        WriteCsvField(out, file.path);
+        out << '\n';
+    }
+    return out.good();
+}
+
+bool WriteBreakdownJson(const ScanBreakdown& breakdown, std::ostream& out) {
+    out << "{\n  \"total_bytes\": " << breakdown.TotalBytes()
+        << ",\n  \"total_files\": " << breakdown.TotalFiles()
+        << ",\n  \"types\": [";
+    const auto& types = breakdown.Types();
+    bool first = true;
+    for (size_t id = 0; id < types.size(); ++id) {
+        if (types[id].files == 0) continue;
+        out << (first ? "\n    {\"type\": " : ",\n    {\"type\": ");
+        WriteJsonString(out, GetFileTypeNameById((int)id));
+        out << ", \"files\": " << types[id].files << ", \"bytes\": " << types[id].bytes << '}';
+        first = false;
+    }
+    out << "\n  ],\n  \"largest_files\": [";
+    first = true;
+    for (const auto& file : breakdown.LargestFiles()) {
+        out << (first ? "\n    {\"path\": " : ",\n    {\"path\": ");
+        WriteJsonString(out, file.path);
+        out << ", \"bytes\": " << file.size << '}';
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
@@ -0,0 +1,61 @@
+#ifndef SCAN_BREAKDOWN_HPP
+#define SCAN_BREAKDOWN_HPP
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bytes and file count of one file type
+struct TypeTotals {
+    unsigned long long bytes = 0;
+    unsigned long long files = 0;
+};
+
+// One entry of the largest-files list
+struct LargeFile {
+    unsigned long long size = 0;
+    std::string path;
+};
+
+// Per-type histograms and the largest N files, collected while a folder scan
+// walks the tree. Each scanning thread owns its own accumulator (no locking on
+// the hot path); accumulators are combined with Merge() once the walks finish.
+class ScanBreakdown {
+public:
+    explicit ScanBreakdown(size_t top_n = 100);
+
+    // Records one file. folder must end with a path separator.
+    void AddFile(const std::string& folder, const char* name, unsigned long long size);
+
+    // Folds another accumulator into this one.
+    void Merge(const ScanBreakdown& other);
+
+    // Totals indexed by file type id (see GetFileTypeId)
+    const std::vector<TypeTotals>& Types() const { return types_; }
+
+    // Largest files, biggest first
+    std::vector<LargeFile> LargestFiles() const;
+
+    unsigned long long TotalBytes() const { return total_bytes_; }
+    unsigned long long TotalFiles() const { return total_files_; }
+
+private:
+    void OfferLargeFile(unsigned long long size, const std::string& folder, const char* name);
+
+    size_t top_n_;
+    std::vector<TypeTotals> types_;
+    std::vector<LargeFile> largest_; // min-heap on size, at most top_n_ entries
+    unsigned long long total_bytes_ = 0;
+    unsigned long long total_files_ = 0;
+    // Per-accumulator extension -> type id cache so the shared registry lock is
+    // taken once per new extension rather than once per file.
+    std::unordered_map<std::string, int> type_id_cache_;
+};
+
+// Streams a breakdown as CSV / JSON. Rows are written as they are produced;
+// nothing is buffered beyond the stream itself. Return true on success.
+bool WriteBreakdownCsv(const ScanBreakdown& breakdown, std::ostream& out);
+bool WriteBreakdownJson(const ScanBreakdown& breakdown, std::ostream& out);
+
+#endif // SCAN_BREAKDOWN_HPP
@@ -0,0 +1,60 @@
+#include "scan_progress.hpp"
+#include <cstdio>
+#include <cstring>
+
+bool ScanProgressFeed::Scan(const std::string& root, ScanOptions options, FolderStats& total, ScanBreakdown* breakdown,
+                            const DirectoryCallback& on_directory) {
+    started_ = std::chrono::steady_clock::now();
+    eta_seconds_ = -1.0;
+    Publish(ScanState::Running, FolderStats(), root, 0.0);
+    options.on_progress = [this, forward = std::move(options.on_progress)](const FolderStats& so_far, const std::string& current, double fraction) {
+        Publish(ScanState::Running, so_far, current, fraction);
+        if (forward) forward(so_far, current, fraction);
+    };
+    bool ok = ScanTree(root, options, total, on_directory, &cancel, breakdown);
+    ScanState state = !ok ? ScanState::Error : (cancel ? ScanState::Cancelled : ScanState::Done);
+    Publish(state, total, root, state == ScanState::Done ? 1.0 : 0.0);
+    return ok;
+}
+
+bool ScanProgressFeed::Finished() const {
+    return IsFinished(Sample().state);
+}
+
+void ScanProgressFeed::Publish(ScanState state, const FolderStats& stats, const std::string& current, double fraction) {
+    ScanProgress progress;
+    progress.stats = stats;
+    progress.state = state;
+    progress.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    if (progress.elapsed_seconds > 0.0) progress.files_per_second = (double)stats.files / progress.elapsed_seconds;
+    progress.fraction = fraction;
+    if (state == ScanState::Running && fraction > 0.001 && progress.elapsed_seconds > 0.5) {
+        // Linear extrapolation, smoothed because the fan-out estimate jumps as folders finish
+        double estimate = progress.elapsed_seconds * (1.0 - fraction) / fraction;
+        eta_seconds_ = eta_seconds_ < 0.0 ? estimate : eta_seconds_ + 0.1 * (estimate - eta_seconds_);
+        progress.eta_seconds = eta_seconds_;
+    } else if (state != ScanState::Running) {
+        progress.eta_seconds = 0.0;
+    }
+    // Keep the tail of long paths, it is the informative part
+    size_t length = current.size();
+    const char* start = current.c_str();
+    if (length >= sizeof(progress.current)) {
+        start += length - (sizeof(progress.current) - 1);
+        length = sizeof(progress.current) - 1;
+    }
+    std::memcpy(progress.current, start, length);
+    progress.current[length] = '\0';
+    progress_.Store(progress);
+}
+
+void FormatDuration(double seconds, char* out, size_t out_size) {
+    unsigned long long total = seconds > 0.0 ? (unsigned long long)(seconds + 0.5) : 0;
+    if (total < 60) {
+        snprintf(out, out_size, "%llus", total);
+    } else if (total < 3600) {
+        snprintf(out, out_size, "%llum %02llus", total / 60, total % 60);
+    } else {
+        snprintf(out, out_size, "%lluh %02llum", total / 3600, (total % 3600) / 60);
+    }
+}
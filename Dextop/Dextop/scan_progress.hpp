@@ -0,0 +1,65 @@
+#ifndef SCAN_PROGRESS_HPP
+#define SCAN_PROGRESS_HPP
+
+#include "scanner.hpp"
+#include "seqlock.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+
+enum class ScanState {
+    Idle,      // not started
+    Running,   // stats hold the totals gathered so far
+    Done,
+    Cancelled, // stats hold the partial totals
+    Error      // the root could not be opened
+};
+
+// The scan has ended: Done, Cancelled or Error
+inline bool IsFinished(ScanState state) {
+    return state == ScanState::Done || state == ScanState::Cancelled || state == ScanState::Error;
+}
+
+// One consistent sample of a scan, cheap to copy
+struct ScanProgress {
+    FolderStats stats;
+    ScanState state = ScanState::Idle;
+    double elapsed_seconds = 0.0;
+    double files_per_second = 0.0;
+    double fraction = 0.0;     // estimated completed share of the tree, 0..1
+    double eta_seconds = -1.0; // estimated time left; negative while unknown
+    char current[260] = {};    // directory being read (truncated)
+};
+
+// Shared between one scan thread and the threads watching it. The scan thread
+// publishes through a seqlock, so the UI can sample it every frame without
+// ever blocking the scan, and a sample is never torn between two updates.
+class ScanProgressFeed {
+public:
+    // Set by observers to stop the scan
+    std::atomic<bool> cancel{false};
+
+    // Scan thread: runs ScanTree on root, publishing progress every
+    // options.progress_interval entries or options.progress_period, whichever
+    // comes first, and the final totals at the end. options.on_progress, if
+    // set, is still called after each publication. Returns what ScanTree returns.
+    bool Scan(const std::string& root, ScanOptions options, FolderStats& total, ScanBreakdown* breakdown = nullptr,
+              const DirectoryCallback& on_directory = nullptr);
+
+    // Any thread. Callers that need several fields take one sample and use its
+    // state rather than calling Finished as well, which samples again.
+    ScanProgress Sample() const { return progress_.Load(); }
+    bool Finished() const;
+
+private:
+    void Publish(ScanState state, const FolderStats& stats, const std::string& current, double fraction);
+
+    SeqLock<ScanProgress> progress_;
+    std::chrono::steady_clock::time_point started_;
+    double eta_seconds_ = -1.0; // smoothed estimate, scan thread only
+};
+
+// Formats seconds as "42s", "3m 05s" or "1h 02m"
+void FormatDuration(double seconds, char* out, size_t out_size);
+
+#endif // SCAN_PROGRESS_HPP
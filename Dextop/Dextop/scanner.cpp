@@ -0,0 +1,363 @@
+#include "scanner.hpp"
+#include "inode_set.hpp"
+#include "scan_breakdown.hpp"
+#include "vfs.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Fields the enumeration must provide for the given options
+unsigned RequiredFields(const ScanOptions& options) {
+    unsigned fields = kVfsSize;
+    if (options.allocated_sizes) fields |= kVfsAllocated;
+    if (options.dedup_hard_links) fields |= kVfsFileIds;
+    if (options.one_file_system || options.follow_links) fields |= kVfsDirIds;
+    return fields;
+}
+
+// Reads one directory through the VFS in batches. An open reader holds one batch,
+// so its cost is bounded regardless of the directory size. Links are resolved
+// here when the options follow them, so callers see the target's type and size;
+// otherwise links to directories are only marked as directories, so they are
+// skipped rather than counted as files.
+class DirReader {
+public:
+    bool Open(Vfs& vfs, const std::string& folder, unsigned fields) {
+        vfs_ = &vfs;
+        folder_ = folder;
+        fields_ = fields;
+        batch_.clear();
+        next_ = 0;
+        error_ = 0;
+        dir_ = vfs.OpenDirectory(folder, fields);
+        return dir_ != nullptr;
+    }
+
+    const VfsEntry* Next(const ScanOptions& options) {
+        while (dir_) {
+            if (next_ == batch_.size()) {
+                next_ = 0;
+                if (!dir_->NextBatch(batch_, kBatchSize)) {
+                    error_ = dir_->Error();
+                    dir_.reset();
+                    return nullptr;
+                }
+                continue;
+            }
+            VfsEntry& entry = batch_[next_++];
+            if (entry.is_link && options.follow_links) {
+                VfsEntry target;
+                if (vfs_->Stat(folder_ + entry.name, target, fields_, true)) {
+                    entry.is_dir = target.is_dir;
+                    entry.size = target.size;
+                    entry.allocated = target.allocated;
+                    entry.has_id = target.has_id;
+                    entry.device = target.device;
+                    entry.inode = target.inode;
+                    entry.links = target.links;
+                }
+            } else if (entry.is_link && !entry.is_dir) {
+                // Junctions already enumerate as directories; POSIX symlinks need the target's type
+                VfsEntry target;
+                if (vfs_->Stat(folder_ + entry.name, target, 0, true) && target.is_dir) entry.is_dir = true;
+            }
+            return &entry;
+        }
+        return nullptr;
+    }
+
+    // Non-zero if the enumeration stopped early with an I/O error
+    int Error() const { return error_; }
+
+    // Directories among the entries of the current batch not returned yet
+    size_t BufferedDirs() const {
+        size_t dirs = 0;
+        for (size_t i = next_; i < batch_.size(); ++i) dirs += batch_[i].is_dir ? 1 : 0;
+        return dirs;
+    }
+
+private:
+    static const size_t kBatchSize = 256;
+
+    Vfs* vfs_ = nullptr;
+    std::unique_ptr<VfsDirectory> dir_;
+    std::string folder_;
+    unsigned fields_ = 0;
+    std::vector<VfsEntry> batch_;
+    size_t next_ = 0;
+    int error_ = 0;
+};
+
+// Applies the link, mount and hard-link rules of ScanOptions to directory entries
+class EntryFilter {
+public:
+    EntryFilter(Vfs& vfs, const std::string& root, const ScanOptions& options) : options_(options) {
+        // Identity of the root, for one_file_system and for loop detection when following links
+        VfsEntry root_entry;
+        if ((options.one_file_system || options.follow_links) && vfs.Stat(root, root_entry, kVfsDirIds) &&
+            root_entry.has_id) {
+            has_root_id_ = true;
+            root_device_ = root_entry.device;
+            root_inode_ = root_entry.inode;
+        }
+        inodes_ = options.shared_inodes;
+        if (options.dedup_hard_links && !inodes_) {
+            local_inodes_ = std::make_unique<InodeSet>();
+            inodes_ = local_inodes_.get();
+        }
+        if (options.follow_links) {
+            visited_dirs_ = std::make_unique<InodeSet>();
+            if (has_root_id_) visited_dirs_->Insert(root_device_, root_inode_);
+        }
+    }
+
+    // False for links that are not followed, other filesystems and directories already entered
+    bool EnterDirectory(const VfsEntry& entry) {
+        if (entry.is_link && !options_.follow_links) return false;
+        if (options_.one_file_system && has_root_id_ && entry.has_id && entry.device != root_device_) return false;
+        if (visited_dirs_ && entry.has_id && !visited_dirs_->Insert(entry.device, entry.inode)) return false;
+        return true;
+    }
+
+    // False for an additional link to a file that was already counted
+    bool CountFile(const VfsEntry& entry) {
+        if (!inodes_ || !entry.has_id || entry.links <= 1) return true;
+        return inodes_->Insert(entry.device, entry.inode);
+    }
+
+private:
+    const ScanOptions& options_;
+    bool has_root_id_ = false;
+    unsigned long long root_device_ = 0;
+    unsigned long long root_inode_ = 0;
+    InodeSet* inodes_ = nullptr;
+    std::unique_ptr<InodeSet> local_inodes_;
+    std::unique_ptr<InodeSet> visited_dirs_;
+};
+
+void AddStats(FolderStats& into, const FolderStats& from) {
+    into.size += from.size;
+    into.allocated += from.allocated;
+    into.files += from.files;
+    into.dirs += from.dirs;
+    into.errors += from.errors;
+    into.hard_links += from.hard_links;
+    into.skipped += from.skipped;
+}
+
+Vfs& ScanVfs(const ScanOptions& options) {
+    return options.vfs ? *options.vfs : NativeVfs();
+}
+
+} // namespace
+
+char PathSeparator() {
+#ifdef _WIN32
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+bool ScanTree(const std::string& root, const ScanOptions& options, FolderStats& total,
+              const DirectoryCallback& on_directory, std::atomic<bool>* cancel_flag,
+              ScanBreakdown* breakdown) {
+    struct Frame {
+        DirReader reader;
+        std::string path;
+        int depth = 0;
+        FolderStats stats;
+        unsigned long long subdirs = 0;      // subfolders met so far, including the open one
+        unsigned long long subdirs_done = 0; // subfolders finished, skipped or reused
+    };
+    total = FolderStats();
+    Vfs& vfs = ScanVfs(options);
+    const unsigned fields = RequiredFields(options);
+    std::vector<Frame> stack;
+    stack.emplace_back();
+    if (!stack.back().reader.Open(vfs, root, fields)) return false;
+    stack.back().path = root;
+
+    EntryFilter filter(vfs, root, options);
+
+    const char separator = vfs.Separator();
+    const unsigned progress_interval = options.progress_interval ? options.progress_interval : 1;
+    unsigned until_progress = progress_interval;
+    // The clock is read every kClockStride entries, and right after each directory
+    // open since that is the slow part on network storage
+    const unsigned kClockStride = 64;
+    unsigned until_clock = kClockStride;
+    const bool timed_progress = options.on_progress && options.progress_period.count() > 0;
+    auto progress_due = std::chrono::steady_clock::now() + options.progress_period;
+    FolderStats reused;
+    while (!stack.empty()) {
+        if (cancel_flag && *cancel_flag) {
+            // Fold the unfinished frames so the caller still gets partial totals
+            while (stack.size() > 1) {
+                AddStats(stack[stack.size() - 2].stats, stack.back().stats);
+                stack.pop_back();
+            }
+            total = stack.back().stats;
+            return true;
+        }
+        Frame& top = stack.back();
+        bool report = options.on_progress && --until_progress == 0;
+        if (timed_progress && !report && --until_clock == 0) {
+            until_clock = kClockStride;
+            report = std::chrono::steady_clock::now() >= progress_due;
+        }
+        if (report) {
+            // Completed subtrees are already folded into their parents, so the open frames hold everything.
+            // Each level contributes its finished share of the subfolders it has met (plus those waiting
+            // in the current batch), scaled by the share of the open subfolder at every level above it.
+            FolderStats so_far;
+            double fraction = 0.0;
+            double scale = 1.0;
+            for (const Frame& frame : stack) {
+                AddStats(so_far, frame.stats);
+                unsigned long long fan_out = frame.subdirs + frame.reader.BufferedDirs();
+                if (fan_out == 0) break;
+                fraction += scale * (double)frame.subdirs_done / (double)fan_out;
+                scale /= (double)fan_out;
+            }
+            options.on_progress(so_far, top.path, fraction);
+            until_progress = progress_interval;
+            if (timed_progress) progress_due = std::chrono::steady_clock::now() + options.progress_period;
+        }
+        if (const VfsEntry* entry = top.reader.Next(options)) {
+            if (entry->is_dir) {
+                top.stats.dirs++;
+                top.subdirs++;
+                if (!filter.EnterDirectory(*entry)) {
+                    top.stats.skipped++;
+                    top.subdirs_done++;
+                    continue;
+                }
+                Frame child;
+                child.path = top.path + entry->name + separator;
+                child.depth = top.depth + 1;
+                if (options.known_subtree && options.known_subtree(child.path, reused)) {
+                    AddStats(top.stats, reused);
+                    top.subdirs_done++;
+                } else if (child.reader.Open(vfs, child.path, fields)) {
+                    stack.push_back(std::move(child)); // invalidates top
+                    until_clock = 1;
+                } else {
+                    top.stats.errors++;
+                    top.subdirs_done++;
+                }
+            } else {
+                if (!filter.CountFile(*entry)) {
+                    top.stats.hard_links++;
+                    continue;
+                }
+                top.stats.files++;
+                top.stats.size += entry->size;
+                if (options.allocated_sizes) top.stats.allocated += entry->allocated;
+                if (breakdown) breakdown->AddFile(top.path, entry->name.c_str(), entry->size);
+            }
+            continue;
+        }
+        // Directory exhausted: report it and fold its totals into the parent
+        Frame done = std::move(stack.back());
+        stack.pop_back();
+        if (done.reader.Error()) done.stats.errors++; // totals cover the entries read before the error
+        if (on_directory && (options.report_depth < 0 || done.depth <= options.report_depth)) {
+            on_directory(done.path, done.depth, done.stats);
+        }
+        if (stack.empty()) {
+            total = done.stats;
+        } else {
+            AddStats(stack.back().stats, done.stats);
+            stack.back().subdirs_done++;
+        }
+    }
+    return true;
+}
+
+bool WalkTreeSorted(const std::string& root, const ScanOptions& options, const DirectoryContentsCallback& on_directory,
+                    std::atomic<bool>* cancel_flag) {
+    struct Frame {
+        std::string path;
+        int depth = 0;
+        std::vector<std::string> subdirs; // sorted, not yet visited from index next
+        size_t next = 0;
+    };
+
+    Vfs& vfs = ScanVfs(options);
+    const unsigned fields = RequiredFields(options);
+    EntryFilter filter(vfs, root, options);
+
+    // Reads one directory completely: own file totals plus the sorted subfolders to visit
+    DirReader reader;
+    auto read_directory = [&](Frame& frame, FolderStats& own) -> bool {
+        if (!reader.Open(vfs, frame.path, fields)) return false;
+        while (const VfsEntry* entry = reader.Next(options)) {
+            if (entry->is_dir) {
+                own.dirs++;
+                if (!filter.EnterDirectory(*entry)) {
+                    own.skipped++;
+                    continue;
+                }
+                frame.subdirs.emplace_back(entry->name);
+            } else {
+                if (!filter.CountFile(*entry)) {
+                    own.hard_links++;
+                    continue;
+                }
+                own.files++;
+                own.size += entry->size;
+                if (options.allocated_sizes) own.allocated += entry->allocated;
+            }
+        }
+        if (reader.Error()) own.errors++;
+        std::sort(frame.subdirs.begin(), frame.subdirs.end());
+        return true;
+    };
+
+    const char separator = vfs.Separator();
+    std::vector<Frame> stack;
+    stack.emplace_back();
+    stack.back().path = root;
+    FolderStats own;
+    if (!read_directory(stack.back(), own)) return false;
+    if (on_directory) on_directory(root, 0, own);
+
+    while (!stack.empty()) {
+        if (cancel_flag && *cancel_flag) break;
+        Frame& top = stack.back();
+        if (top.next == top.subdirs.size()) {
+            stack.pop_back();
+            continue;
+        }
+        Frame child;
+        child.path = top.path + top.subdirs[top.next++] + separator;
+        child.depth = top.depth + 1;
+        own = FolderStats();
+        if (!read_directory(child, own)) own.errors++;
+        if (on_directory) on_directory(child.path, child.depth, own);
+        if (!child.subdirs.empty()) stack.push_back(std::move(child)); // invalidates top
+    }
+    return true;
+}
+
+int ComparePaths(const std::string& a, const std::string& b, char separator) {
+    const size_t n = a.size() < b.size() ? a.size() : b.size();
+    for (size_t i = 0; i < n; ++i) {
+        if (a[i] == b[i]) continue;
+        // Map the separator below every other byte so "a/b" sorts before "a-c"
+        int ca = (a[i] == separator) ? -1 : (unsigned char)a[i];
+        int cb = (b[i] == separator) ? -1 : (unsigned char)b[i];
+        return ca < cb ? -1 : 1;
+    }
+    return (a.size() < b.size()) ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+void GetFolderStatsRecursive(const std::string& folder, FolderStats& stats, std::atomic<bool>* cancel_flag,
+                             ScanBreakdown* breakdown, const ScanOptions& options) {
+    ScanTree(folder, options, stats, nullptr, cancel_flag, breakdown);
+}
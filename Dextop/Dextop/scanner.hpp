@@ -0,0 +1,90 @@
+#ifndef SCANNER_HPP
+#define SCANNER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
+class ScanBreakdown;
+class InodeSet;
+class Vfs;
+
+// Helper struct for folder stats
+struct FolderStats {
+    unsigned long long size = 0;      // apparent bytes
+    unsigned long long allocated = 0; // bytes allocated on disk (ScanOptions::allocated_sizes)
+    unsigned long long files = 0;     // total files (recursive)
+    unsigned long long dirs = 0;      // total subfolders (recursive)
+    unsigned long long errors = 0;    // subfolders that could not be opened or read to the end
+    unsigned long long hard_links = 0; // extra links to files already counted
+    unsigned long long skipped = 0;   // links, junctions and mount points not descended into
+                                      // (unfollowed links to files count as files)
+};
+
+struct ScanOptions {
+    // Directories up to this depth (root = 0) are passed to the callback; -1 reports all of them
+    int report_depth = -1;
+    // Also measure allocated bytes (st_blocks on POSIX, GetCompressedFileSize on Windows)
+    bool allocated_sizes = false;
+    // Count every (device, inode) once, so hard-linked backup trees are not summed repeatedly
+    bool dedup_hard_links = false;
+    // Do not descend into directories that live on another filesystem / volume than the root
+    bool one_file_system = false;
+    // Follow symlinks, junctions and other reparse points. Directories are still
+    // entered only once each, so link loops terminate.
+    bool follow_links = false;
+    // Optional set shared between scans (e.g. of several checked folders) so a file
+    // hard-linked into more than one of them is counted once. Used with dedup_hard_links.
+    InodeSet* shared_inodes = nullptr;
+    // Filesystem to scan; NativeVfs() when null. Paths use its separator.
+    Vfs* vfs = nullptr;
+    // ScanTree only: consulted before descending into a directory. Returning true
+    // with the subtree totals in stats reuses them instead of walking it again
+    // (such subtrees are not reported to the callback or the breakdown).
+    std::function<bool(const std::string& path, FolderStats& stats)> known_subtree;
+    // ScanTree only: called every progress_interval entries, or once progress_period
+    // has passed on storage too slow to reach that count, with the totals gathered
+    // so far, the directory being read and an estimate of the completed fraction
+    // of the tree (0..1) derived from the subfolder fan-out seen so far
+    std::function<void(const FolderStats& so_far, const std::string& current, double fraction)> on_progress;
+    unsigned progress_interval = 4096;
+    std::chrono::milliseconds progress_period{250}; // 0: by entry count only
+};
+
+// Called once per directory when its whole subtree has been walked, so children
+// are always reported before their parent. path ends with a separator.
+using DirectoryCallback = std::function<void(const std::string& path, int depth, const FolderStats& stats)>;
+
+// Native path separator ('\\' on Windows, '/' elsewhere)
+char PathSeparator();
+
+// Walks the tree below root (which must end with a separator) depth-first with an
+// explicit stack. Memory use is proportional to the tree depth, not its size.
+// Returns false if root itself cannot be opened. On cancellation the partial
+// totals gathered so far are returned in total.
+bool ScanTree(const std::string& root, const ScanOptions& options, FolderStats& total,
+              const DirectoryCallback& on_directory = nullptr, std::atomic<bool>* cancel_flag = nullptr,
+              ScanBreakdown* breakdown = nullptr);
+
+// Called in pre-order with the direct contents of one directory: own.size and
+// own.files cover the files directly inside it, own.dirs its subfolders.
+using DirectoryContentsCallback = std::function<void(const std::string& path, int depth, const FolderStats& own)>;
+
+// Walks the tree below root in pre-order, visiting subfolders in byte-wise name
+// order, so the reported paths come out in the order defined by ComparePaths.
+// Each directory is read completely before descending; memory is proportional
+// to depth times the subfolder fan-out. Returns false if root cannot be opened.
+bool WalkTreeSorted(const std::string& root, const ScanOptions& options, const DirectoryContentsCallback& on_directory,
+                    std::atomic<bool>* cancel_flag = nullptr);
+
+// Orders paths component by component (the separator sorts before any other
+// character), which is the order WalkTreeSorted produces. Returns <0, 0 or >0.
+int ComparePaths(const std::string& a, const std::string& b, char separator);
+
+// Recursively compute folder stats (size and file count). When a breakdown is given,
+// per-type histograms and the largest files are collected in the same pass.
+void GetFolderStatsRecursive(const std::string& folder, FolderStats& stats, std::atomic<bool>* cancel_flag = nullptr,
+                             ScanBreakdown* breakdown = nullptr, const ScanOptions& options = ScanOptions());
+
+#endif // SCANNER_HPP
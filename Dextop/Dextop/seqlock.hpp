@@ -0,0 +1,63 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// Publishes a small value from one writer thread to any number of readers
+// without locks. The writer never waits; a reader that overlaps a write
+// retries, so it always sees one complete value and never a mix of two.
+// The payload is kept in atomic words, which makes the concurrent copy
+// well-defined. T must be trivially copyable.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock needs a trivially copyable type");
+
+public:
+    SeqLock() { Store(T()); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Only one thread may store at a time
+    void Store(const T& value) {
+        std::uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        const unsigned sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) words_[i].store(words[i], std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T Load() const {
+        std::uint64_t words[kWords];
+        for (;;) {
+            const unsigned before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i) words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) break;
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // Number of stores so far, so readers can tell whether anything changed
+    unsigned Version() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<unsigned> sequence_{0};
+    std::atomic<std::uint64_t> words_[kWords];
+};
+
+#endif // SEQLOCK_HPP
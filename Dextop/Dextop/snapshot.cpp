@@ -0,0 +1,296 @@
+#include "snapshot.hpp"
+#include "vfs.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kSnapshotMagic[8] = { 'D', 'X', 'S', 'N', 'A', 'P', '1', '\n' };
+const size_t kBufferSize = 1 << 20;
+
+// True if a ranks above b: grew more, or changed more either way
+bool RanksAbove(const SnapshotDelta& a, const SnapshotDelta& b, DiffRank rank) {
+    if (rank == DiffRank::Change) return a.Change() > b.Change();
+    return a.Growth() > b.Growth();
+}
+
+bool IsAncestor(const std::string& ancestor, const std::string& path) {
+    if (ancestor.empty()) return !path.empty();
+    return path.size() > ancestor.size() && path[ancestor.size()] == '/' &&
+           path.compare(0, ancestor.size(), ancestor) == 0;
+}
+
+int PathDepth(const std::string& path) {
+    if (path.empty()) return 0;
+    return 1 + (int)std::count(path.begin(), path.end(), '/');
+}
+
+} // namespace
+
+// --- SnapshotWriter ---
+
+SnapshotWriter::~SnapshotWriter() {
+    Close();
+}
+
+bool SnapshotWriter::Open(const std::string& file_path, const std::string& root) {
+    Close();
+    file_ = fopen(file_path.c_str(), "wb");
+    if (!file_) return false;
+    failed_ = false;
+    previous_path_.clear();
+    buffer_.clear();
+    buffer_.reserve(kBufferSize);
+    PutBytes(kSnapshotMagic, sizeof(kSnapshotMagic));
+    PutVarint(root.size());
+    PutBytes(root.data(), root.size());
+    return true;
+}
+
+void SnapshotWriter::Add(const SnapshotRecord& record) {
+    size_t shared = 0;
+    const size_t limit = std::min(previous_path_.size(), record.path.size());
+    while (shared < limit && previous_path_[shared] == record.path[shared]) shared++;
+    PutVarint(shared);
+    PutVarint(record.path.size() - shared);
+    PutBytes(record.path.data() + shared, record.path.size() - shared);
+    PutVarint(record.bytes);
+    PutVarint(record.allocated);
+    PutVarint(record.files);
+    previous_path_.assign(record.path);
+}
+
+bool SnapshotWriter::Close() {
+    if (!file_) return !failed_;
+    if (!buffer_.empty() && fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) failed_ = true;
+    buffer_.clear();
+    if (fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+void SnapshotWriter::PutByte(unsigned char byte) {
+    if (buffer_.size() == kBufferSize) {
+        if (fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) failed_ = true;
+        buffer_.clear();
+    }
+    buffer_.push_back(byte);
+}
+
+void SnapshotWriter::PutVarint(unsigned long long value) {
+    while (value >= 0x80) {
+        PutByte((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    PutByte((unsigned char)value);
+}
+
+void SnapshotWriter::PutBytes(const char* data, size_t size) {
+    if (buffer_.size() + size <= kBufferSize) {
+        size_t used = buffer_.size();
+        buffer_.resize(used + size);
+        if (size > 0) memcpy(buffer_.data() + used, data, size);
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) PutByte((unsigned char)data[i]);
+}
+
+// --- SnapshotReader ---
+
+SnapshotReader::~SnapshotReader() {
+    if (file_) fclose(file_);
+}
+
+bool SnapshotReader::Open(const std::string& file_path) {
+    if (file_) fclose(file_);
+    file_ = fopen(file_path.c_str(), "rb");
+    if (!file_) return false;
+    buffer_.resize(kBufferSize);
+    pos_ = end_ = 0;
+    corrupt_ = false;
+    std::string magic;
+    unsigned long long root_size = 0;
+    root_.clear();
+    if (!GetBytes(magic, sizeof(kSnapshotMagic)) || memcmp(magic.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        !GetVarint(root_size) || root_size > 65536 || !GetBytes(root_, (size_t)root_size)) {
+        corrupt_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::Next(SnapshotRecord& record) {
+    unsigned long long shared = 0, suffix = 0;
+    if (pos_ == end_ && !Fill()) return false; // clean end of file
+    if (!GetVarint(shared) || !GetVarint(suffix) || shared > record.path.size() || suffix > 65536) {
+        corrupt_ = true;
+        return false;
+    }
+    record.path.resize((size_t)shared);
+    if (!GetBytes(record.path, (size_t)suffix) || !GetVarint(record.bytes) || !GetVarint(record.allocated) || !GetVarint(record.files)) {
+        corrupt_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::Fill() {
+    if (!file_) return false;
+    end_ = fread(buffer_.data(), 1, buffer_.size(), file_);
+    pos_ = 0;
+    return end_ > 0;
+}
+
+bool SnapshotReader::GetByte(unsigned char& byte) {
+    if (pos_ == end_ && !Fill()) return false;
+    byte = buffer_[pos_++];
+    return true;
+}
+
+bool SnapshotReader::GetVarint(unsigned long long& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        unsigned char byte;
+        if (!GetByte(byte)) return false;
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Appends size bytes to out
+bool SnapshotReader::GetBytes(std::string& out, size_t size) {
+    while (size > 0) {
+        if (pos_ == end_ && !Fill()) return false;
+        size_t take = std::min(size, end_ - pos_);
+        out.append((const char*)buffer_.data() + pos_, take);
+        pos_ += take;
+        size -= take;
+    }
+    return true;
+}
+
+// --- Scanning and diffing ---
+
+bool WriteSnapshot(const std::string& root, const ScanOptions& options, const std::string& file_path,
+                   FolderStats& total, std::string& error) {
+    SnapshotWriter writer;
+    if (!writer.Open(file_path, root)) {
+        error = "cannot create '" + file_path + "'";
+        return false;
+    }
+    const char separator = (options.vfs ? *options.vfs : NativeVfs()).Separator();
+    SnapshotRecord record;
+    total = FolderStats();
+    bool ok = WalkTreeSorted(root, options, [&](const std::string& path, int, const FolderStats& own) {
+        // Relative path without the trailing separator, always '/' separated
+        record.path.assign(path, root.size(), std::string::npos);
+        if (!record.path.empty()) record.path.pop_back();
+        if (separator != '/') std::replace(record.path.begin(), record.path.end(), separator, '/');
+        record.bytes = own.size;
+        record.allocated = own.allocated;
+        record.files = own.files;
+        writer.Add(record);
+        total.size += own.size;
+        total.allocated += own.allocated;
+        total.files += own.files;
+        total.dirs += own.dirs;
+        total.errors += own.errors;
+        total.hard_links += own.hard_links;
+        total.skipped += own.skipped;
+    });
+    if (!ok) {
+        writer.Close();
+        remove(file_path.c_str());
+        error = "cannot open '" + root + "'";
+        return false;
+    }
+    if (!writer.Close()) {
+        error = "failed writing '" + file_path + "'";
+        return false;
+    }
+    return true;
+}
+
+bool DiffSnapshots(const std::string& old_path, const std::string& new_path, const DiffOptions& options,
+                   std::vector<SnapshotDelta>& ranked, SnapshotDelta& root, std::string& error) {
+    SnapshotReader old_reader, new_reader;
+    if (!old_reader.Open(old_path)) {
+        error = "'" + old_path + "' is not a readable snapshot";
+        return false;
+    }
+    if (!new_reader.Open(new_path)) {
+        error = "'" + new_path + "' is not a readable snapshot";
+        return false;
+    }
+    if (!options.any_root && old_reader.Root() != new_reader.Root()) {
+        error = "snapshots are of different roots ('" + old_reader.Root() + "' and '" + new_reader.Root() + "')";
+        return false;
+    }
+
+    // Open ancestors of the current path; their subtree totals are complete once popped
+    std::vector<SnapshotDelta> stack;
+    ranked.clear();
+    root = SnapshotDelta();
+
+    // min-heap on rank: the front is the weakest of the kept entries
+    auto ranks_above = [&options](const SnapshotDelta& a, const SnapshotDelta& b) { return RanksAbove(a, b, options.rank); };
+    auto finish_top = [&]() {
+        SnapshotDelta done = std::move(stack.back());
+        stack.pop_back();
+        if (!stack.empty()) {
+            SnapshotDelta& parent = stack.back();
+            parent.old_bytes += done.old_bytes;
+            parent.new_bytes += done.new_bytes;
+            parent.old_files += done.old_files;
+            parent.new_files += done.new_files;
+        } else {
+            root = done;
+        }
+        if (options.top == 0 || (options.max_depth >= 0 && done.depth > options.max_depth)) return;
+        if (!done.Changed()) return;
+        if (ranked.size() < options.top) {
+            ranked.push_back(std::move(done));
+            std::push_heap(ranked.begin(), ranked.end(), ranks_above);
+        } else if (ranks_above(done, ranked.front())) {
+            std::pop_heap(ranked.begin(), ranked.end(), ranks_above);
+            ranked.back() = std::move(done);
+            std::push_heap(ranked.begin(), ranked.end(), ranks_above);
+        }
+    };
+
+    SnapshotRecord a, b;
+    bool has_a = old_reader.Next(a);
+    bool has_b = new_reader.Next(b);
+    while (has_a || has_b) {
+        int cmp = !has_a ? 1 : (!has_b ? -1 : ComparePaths(a.path, b.path, '/'));
+        const std::string& path = (cmp <= 0) ? a.path : b.path;
+        while (!stack.empty() && !IsAncestor(stack.back().path, path)) finish_top();
+
+        SnapshotDelta delta;
+        delta.path = path;
+        delta.depth = PathDepth(path);
+        if (cmp <= 0) {
+            delta.in_old = true;
+            delta.old_bytes = a.bytes;
+            delta.old_files = a.files;
+        }
+        if (cmp >= 0) {
+            delta.in_new = true;
+            delta.new_bytes = b.bytes;
+            delta.new_files = b.files;
+        }
+        stack.push_back(std::move(delta));
+
+        if (cmp <= 0) has_a = old_reader.Next(a);
+        if (cmp >= 0) has_b = new_reader.Next(b);
+    }
+    while (!stack.empty()) finish_top();
+
+    if (old_reader.Corrupt() || new_reader.Corrupt()) {
+        error = "snapshot '" + (old_reader.Corrupt() ? old_path : new_path) + "' is truncated or corrupt";
+        return false;
+    }
+    std::sort(ranked.begin(), ranked.end(), ranks_above);
+    return true;
+}
@@ -0,0 +1,119 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include "scanner.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A scan snapshot is a compact binary file with one record per directory,
+// stored in ComparePaths order of the path relative to the scanned root ('/'
+// separated, "" for the root itself). Each record holds the directory's own
+// files only; subtree totals are rebuilt while reading. Paths are prefix
+// compressed against the previous record and numbers are varints, so a
+// snapshot costs a few bytes per directory plus the new part of its name.
+
+struct SnapshotRecord {
+    std::string path;                 // relative, '/' separated
+    unsigned long long bytes = 0;     // own files, apparent bytes
+    unsigned long long allocated = 0; // own files, allocated bytes
+    unsigned long long files = 0;     // own files
+};
+
+class SnapshotWriter {
+public:
+    SnapshotWriter() = default;
+    ~SnapshotWriter();
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    bool Open(const std::string& file_path, const std::string& root);
+    // Records must be added in ComparePaths order
+    void Add(const SnapshotRecord& record);
+    // Flushes and closes the file. Returns false if any write failed.
+    bool Close();
+
+private:
+    void PutByte(unsigned char byte);
+    void PutVarint(unsigned long long value);
+    void PutBytes(const char* data, size_t size);
+
+    FILE* file_ = nullptr;
+    std::vector<unsigned char> buffer_;
+    std::string previous_path_;
+    bool failed_ = false;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader() = default;
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    // Returns false if the file is missing or not a snapshot
+    bool Open(const std::string& file_path);
+    const std::string& Root() const { return root_; }
+    // Reads the next record. record must be the one passed to the previous call, since
+    // its path is the base of the prefix compression. False at the end or on a corrupt file.
+    bool Next(SnapshotRecord& record);
+    bool Corrupt() const { return corrupt_; }
+
+private:
+    bool Fill();
+    bool GetByte(unsigned char& byte);
+    bool GetVarint(unsigned long long& value);
+    bool GetBytes(std::string& out, size_t size);
+
+    FILE* file_ = nullptr;
+    std::vector<unsigned char> buffer_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    std::string root_;
+    bool corrupt_ = false;
+};
+
+// Scans root (ending with a separator) with WalkTreeSorted and writes the snapshot
+// to file_path. total receives the tree totals. Returns false with a message in error.
+bool WriteSnapshot(const std::string& root, const ScanOptions& options, const std::string& file_path,
+                   FolderStats& total, std::string& error);
+
+// Change of one directory subtree between two snapshots
+struct SnapshotDelta {
+    std::string path; // relative, '/' separated, "" for the root
+    int depth = 0;
+    unsigned long long old_bytes = 0;
+    unsigned long long new_bytes = 0;
+    unsigned long long old_files = 0;
+    unsigned long long new_files = 0;
+    bool in_old = false;
+    bool in_new = false;
+
+    long long Growth() const { return (long long)(new_bytes - old_bytes); }
+    // Size of the change either way
+    unsigned long long Change() const { return new_bytes > old_bytes ? new_bytes - old_bytes : old_bytes - new_bytes; }
+    bool Changed() const { return !in_old || !in_new || new_bytes != old_bytes || new_files != old_files; }
+};
+
+enum class DiffRank {
+    Growth, // most growth first, shrinking directories last
+    Change  // largest change first, growing or shrinking
+};
+
+struct DiffOptions {
+    size_t top = 20;       // number of changed directories to keep, in rank order
+    DiffRank rank = DiffRank::Growth;
+    int max_depth = -1;    // only rank directories up to this depth (-1: all)
+    bool any_root = false; // allow snapshots taken of different roots
+};
+
+// Streaming merge-join of two snapshots. Subtree totals are accumulated on a
+// stack of open ancestors, and only the top directories by change are kept, so
+// memory is bounded by tree depth plus options.top regardless of snapshot size.
+// ranked holds changed directories only, growing or shrinking, ordered by
+// options.rank; root receives the whole-tree delta. Fails if the snapshots were
+// taken of different roots unless options.any_root is set.
+bool DiffSnapshots(const std::string& old_path, const std::string& new_path, const DiffOptions& options,
+                   std::vector<SnapshotDelta>& ranked, SnapshotDelta& root, std::string& error);
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,61 @@
+#ifndef TEXT_OUTPUT_HPP
+#define TEXT_OUTPUT_HPP
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+// Writes a JSON string literal (with quotes), escaping control characters.
+inline void WriteJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (unsigned char c : value) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out << buf;
+            } else {
+                out << (char)c;
+            }
+        }
+    }
+    out << '"';
+}
+
+// Writes a CSV field, quoting it when it contains a delimiter, quote or newline.
+inline void WriteCsvField(std::ostream& out, const std::string& field) {
+    if (field.find_first_of(",\"\r\n") == std::string::npos) {
+        out << field;
+        return;
+    }
+    out << '"';
+    for (char c : field) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+// Formats a byte count with a binary unit suffix, e.g. "12.34 GB"
+inline void FormatByteSize(unsigned long long bytes, char* out, size_t out_size) {
+    double size = (double)bytes;
+    if (size < 1024) {
+        snprintf(out, out_size, "%llu bytes", bytes);
+    } else if (size < 1024 * 1024) {
+        snprintf(out, out_size, "%.2f KB", size / 1024.0);
+    } else if (size < 1024 * 1024 * 1024) {
+        snprintf(out, out_size, "%.2f MB", size / (1024.0 * 1024.0));
+    } else if (size < 1024.0 * 1024.0 * 1024.0 * 1024.0) {
+        snprintf(out, out_size, "%.2f GB", size / (1024.0 * 1024.0 * 1024.0));
+    } else {
+        snprintf(out, out_size, "%.2f TB", size / (1024.0 * 1024.0 * 1024.0 * 1024.0));
+    }
+}
+
+#endif // TEXT_OUTPUT_HPP
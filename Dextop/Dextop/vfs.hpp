@@ -0,0 +1,94 @@
+#ifndef VFS_HPP
+#define VFS_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Virtual filesystem used by every engine (scanner, snapshots, listing) so they
+// can run against the native filesystem or a deterministic in-memory tree.
+// All paths are UTF-8; directory paths end with the backend's separator.
+
+// Metadata a caller asks for when enumerating or stat-ing. Backends always fill
+// name, is_dir and is_link; everything else is only guaranteed when requested,
+// so enumerations do not pay for a stat() per entry unless it is needed.
+enum VfsFields : unsigned {
+    kVfsSize = 1 << 0,      // size (files)
+    kVfsAllocated = 1 << 1, // allocated bytes on disk (files)
+    kVfsFileIds = 1 << 2,   // device/inode/links of files
+    kVfsDirIds = 1 << 3,    // device/inode of directories
+    kVfsTimes = 1 << 4,     // modification time
+    kVfsAttributes = 1 << 5 // platform attributes / mode bits
+};
+
+struct VfsEntry {
+    std::string name;
+    bool is_dir = false;
+    bool is_link = false;          // symlink / reparse point itself (not followed)
+    unsigned long long size = 0;
+    unsigned long long allocated = 0;
+    long long modified = 0;        // seconds since the Unix epoch
+    unsigned attributes = 0;       // FILE_ATTRIBUTE_* on Windows, st_mode elsewhere
+    bool has_id = false;           // device/inode/links are valid
+    unsigned long long device = 0;
+    unsigned long long inode = 0;
+    unsigned long long links = 1;
+};
+
+// An open directory enumeration
+class VfsDirectory {
+public:
+    virtual ~VfsDirectory() = default;
+    // Replaces the contents of batch with up to max_entries entries ("." and ".."
+    // excluded). Returns false once the directory is exhausted or on error.
+    virtual bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) = 0;
+    // Non-zero if enumeration stopped because of an I/O error
+    virtual int Error() const { return 0; }
+};
+
+// An open file, read sequentially
+class VfsFile {
+public:
+    virtual ~VfsFile() = default;
+    // Returns the number of bytes read, 0 at end of file, -1 on error
+    virtual long long Read(void* buffer, size_t size) = 0;
+};
+
+// Change notification for one directory
+class VfsWatch {
+public:
+    virtual ~VfsWatch() = default;
+    // True if the directory's entries changed since the previous call. names
+    // receives the entries that changed when the backend can tell, and is left
+    // empty when anything may have changed. Never blocks.
+    virtual bool Changed(std::vector<std::string>& names) = 0;
+};
+
+class Vfs {
+public:
+    virtual ~Vfs() = default;
+
+    virtual char Separator() const = 0;
+
+    // Fields every enumeration fills without extra calls, whatever was requested
+    virtual unsigned EnumeratedFields() const { return 0; }
+
+    // Returns nullptr if the directory cannot be opened
+    virtual std::unique_ptr<VfsDirectory> OpenDirectory(const std::string& path, unsigned fields) = 0;
+
+    // Metadata of a path. Directories may be given with or without the trailing
+    // separator. follow_links resolves a final symlink before reporting.
+    virtual bool Stat(const std::string& path, VfsEntry& entry, unsigned fields, bool follow_links = true) = 0;
+
+    // Returns nullptr if the file cannot be opened for reading
+    virtual std::unique_ptr<VfsFile> OpenFile(const std::string& path) = 0;
+
+    // Returns nullptr if the backend cannot watch this path
+    virtual std::unique_ptr<VfsWatch> Watch(const std::string& path) = 0;
+};
+
+// The backend for the running platform (POSIX or Win32 wide-char, long-path aware)
+Vfs& NativeVfs();
+
+#endif // VFS_HPP
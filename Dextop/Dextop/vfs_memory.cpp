@@ -0,0 +1,580 @@
+#include "vfs_memory.hpp"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const unsigned long long kDevice = 1;
+const unsigned long long kSyntheticInodeBit = 1ULL << 63;
+const int kMaxLinks = 40; // symlinks followed while resolving one path, as on Linux
+const char* const kSyntheticExtensions[] = { "txt", "log", "jpg", "png", "mp4", "cpp", "json", "zip" };
+
+unsigned long long Mix(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+unsigned long long HashPath(const std::string& path) {
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : path) hash = (hash ^ c) * 0x100000001b3ULL;
+    return Mix(hash);
+}
+
+unsigned long long ChildDirHash(unsigned long long parent, unsigned index) {
+    return Mix(parent ^ ((unsigned long long)(index + 1) * 0xD1B54A32D192ED03ULL));
+}
+
+unsigned long long FileHash(unsigned long long parent, unsigned index) {
+    return Mix(parent + (unsigned long long)(index + 1) * 0x8CB92BA72F3D8DD7ULL);
+}
+
+// Splits "/a/b/" into {"a", "b"}
+std::vector<std::string> SplitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (end > start) parts.emplace_back(path, start, end - start);
+        start = end + 1;
+    }
+    return parts;
+}
+
+// Parses the decimal index after a one-letter prefix ("d12", "f7.log"). Stops at
+// a '.' when allow_extension is set; leading zeros are rejected so every entry
+// has exactly one name.
+bool ParseIndex(const std::string& name, char prefix, bool allow_extension, unsigned& index, size_t& end) {
+    if (name.size() < 2 || name[0] != prefix) return false;
+    unsigned long long value = 0;
+    size_t i = 1;
+    for (; i < name.size() && name[i] >= '0' && name[i] <= '9'; ++i) {
+        value = value * 10 + (name[i] - '0');
+        if (value > 0xFFFFFFFFULL) return false;
+    }
+    if (i == 1 || (name[1] == '0' && i > 2)) return false;
+    if (i != name.size() && !(allow_extension && name[i] == '.')) return false;
+    index = (unsigned)value;
+    end = i;
+    return true;
+}
+
+} // namespace
+
+struct MemoryVfs::Node {
+    bool is_dir = true;
+    unsigned long long inode = 0;
+    unsigned long long generation = 0;
+    // Files: shared between hard links
+    struct FileData {
+        unsigned long long size = 0;
+        unsigned long long allocated = 0;
+        unsigned long long inode = 0;
+        unsigned long long links = 1;
+    };
+    std::shared_ptr<FileData> file;
+    // Symlinks: absolute target path
+    std::string link_target;
+    // Directories
+    unsigned long long device = 0; // root of another filesystem (0: the parent's)
+    std::map<std::string, std::unique_ptr<Node>> children;
+    std::unique_ptr<SyntheticTreeSpec> synthetic;
+};
+
+// A path looked up either in the explicit tree or inside a generated tree
+struct MemoryVfs::Resolved {
+    Node* node = nullptr;        // explicit entry, or the mount point of a generated tree
+    bool generated = false;
+    SyntheticTreeSpec spec;      // generated entries only
+    int level = 0;               // depth below the mount point
+    unsigned long long hash = 0; // directory hash, or file hash
+    bool is_dir = true;
+    unsigned file_index = 0;
+    unsigned long long device = kDevice; // of the directory, or of the directory holding the file
+};
+
+namespace {
+
+void FillSyntheticFile(const SyntheticTreeSpec& spec, unsigned long long hash, unsigned index, unsigned long long device,
+                       VfsEntry& entry) {
+    entry.name.assign(1, 'f');
+    entry.name += std::to_string(index);
+    entry.name += '.';
+    entry.name += kSyntheticExtensions[hash % 8];
+    entry.is_dir = false;
+    // Most files small, a few large: divide a uniform size by a random power of two
+    unsigned long long size = spec.max_file_size ? (hash >> 8) % (spec.max_file_size + 1) : 0;
+    entry.size = size >> ((hash >> 59) % 16);
+    entry.allocated = (entry.size + 4095) & ~4095ULL;
+    entry.modified = 1600000000 + (long long)(hash % 100000000);
+    entry.attributes = 0100644;
+    entry.has_id = true;
+    entry.device = device;
+    entry.inode = hash | kSyntheticInodeBit;
+    entry.links = 1;
+}
+
+void FillSyntheticDirectory(unsigned long long hash, unsigned index, unsigned long long device, VfsEntry& entry) {
+    entry.name.assign(1, 'd');
+    entry.name += std::to_string(index);
+    entry.is_dir = true;
+    entry.modified = 1600000000 + (long long)(hash % 100000000);
+    entry.attributes = 040755;
+    entry.has_id = true;
+    entry.device = device;
+    entry.inode = hash | kSyntheticInodeBit;
+}
+
+// device is that of the directory holding the node
+void FillNode(const MemoryVfs::Node& node, unsigned long long device, VfsEntry& entry) {
+    entry.is_dir = node.is_dir;
+    entry.is_link = !node.link_target.empty();
+    entry.has_id = true;
+    entry.device = node.device ? node.device : device;
+    entry.modified = 1600000000;
+    if (entry.is_link) {
+        entry.size = node.link_target.size();
+        entry.inode = node.inode;
+        entry.attributes = 0120777;
+    } else if (node.file) {
+        entry.size = node.file->size;
+        entry.allocated = node.file->allocated;
+        entry.inode = node.file->inode;
+        entry.links = node.file->links;
+        entry.attributes = 0100644;
+    } else {
+        entry.inode = node.inode;
+        entry.attributes = 040755;
+    }
+}
+
+void Sleep(long long latency_us) {
+    if (latency_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+}
+
+unsigned long long SyntheticRootHash(const SyntheticTreeSpec& spec, unsigned long long mount_inode) {
+    return Mix(spec.seed ^ (mount_inode * 0xA24BAED4963EE407ULL));
+}
+
+class SyntheticDirectory : public VfsDirectory {
+public:
+    SyntheticDirectory(const SyntheticTreeSpec& spec, int level, unsigned long long hash, unsigned long long device,
+                       long long latency_us)
+        : spec_(spec), hash_(hash), device_(device), dirs_(level < spec.depth ? spec.dirs_per_dir : 0),
+          latency_us_(latency_us) {}
+
+    bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) override {
+        Sleep(latency_us_);
+        const unsigned long long total = (unsigned long long)dirs_ + spec_.files_per_dir;
+        size_t count = (size_t)std::min<unsigned long long>(max_entries, total - next_);
+        batch.resize(count);
+        for (size_t i = 0; i < count; ++i, ++next_) {
+            batch[i] = VfsEntry();
+            if (next_ < dirs_) {
+                FillSyntheticDirectory(ChildDirHash(hash_, (unsigned)next_), (unsigned)next_, device_, batch[i]);
+            } else {
+                unsigned index = (unsigned)(next_ - dirs_);
+                FillSyntheticFile(spec_, FileHash(hash_, index), index, device_, batch[i]);
+            }
+        }
+        return count > 0;
+    }
+
+private:
+    SyntheticTreeSpec spec_;
+    unsigned long long hash_;
+    unsigned long long device_;
+    unsigned dirs_;
+    long long latency_us_;
+    unsigned long long next_ = 0;
+};
+
+// Entries copied when the directory is opened, so enumeration needs no lock
+class ListedDirectory : public VfsDirectory {
+public:
+    ListedDirectory(std::vector<VfsEntry> entries, long long latency_us)
+        : entries_(std::move(entries)), latency_us_(latency_us) {}
+
+    bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) override {
+        Sleep(latency_us_);
+        size_t count = std::min(max_entries, entries_.size() - next_);
+        batch.assign(entries_.begin() + next_, entries_.begin() + next_ + count);
+        next_ += count;
+        return count > 0;
+    }
+
+private:
+    std::vector<VfsEntry> entries_;
+    long long latency_us_;
+    size_t next_ = 0;
+};
+
+// Passes through the first limit entries of another directory, then fails
+class FailingDirectory : public VfsDirectory {
+public:
+    FailingDirectory(std::unique_ptr<VfsDirectory> inner, size_t limit, int error)
+        : inner_(std::move(inner)), limit_(limit), error_(error) {}
+
+    bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) override {
+        if (returned_ >= limit_) {
+            batch.clear();
+            failed_ = true;
+            return false;
+        }
+        if (!inner_->NextBatch(batch, std::min(max_entries, limit_ - returned_))) return false;
+        returned_ += batch.size();
+        return true;
+    }
+
+    int Error() const override { return failed_ ? error_ : inner_->Error(); }
+
+private:
+    std::unique_ptr<VfsDirectory> inner_;
+    size_t limit_;
+    int error_;
+    size_t returned_ = 0;
+    bool failed_ = false;
+};
+
+class MemoryFile : public VfsFile {
+public:
+    MemoryFile(unsigned long long size, unsigned long long seed) : size_(size), seed_(seed) {}
+
+    long long Read(void* buffer, size_t size) override {
+        size_t count = (size_t)std::min<unsigned long long>(size, size_ - offset_);
+        unsigned char* out = (unsigned char*)buffer;
+        for (size_t i = 0; i < count; ++i, ++offset_) {
+            out[i] = (unsigned char)(Mix(seed_ ^ (offset_ >> 3)) >> ((offset_ & 7) * 8));
+        }
+        return (long long)count;
+    }
+
+private:
+    unsigned long long size_;
+    unsigned long long seed_;
+    unsigned long long offset_ = 0;
+};
+
+class MemoryWatch : public VfsWatch {
+public:
+    MemoryWatch(MemoryVfs& vfs, const std::string& path)
+        : vfs_(vfs), path_(path), generation_(vfs.Generation(path)) {}
+
+    bool Changed(std::vector<std::string>& names) override {
+        names.clear();
+        unsigned long long generation = vfs_.Generation(path_);
+        if (generation == generation_) return false;
+        generation_ = generation;
+        return true;
+    }
+
+private:
+    MemoryVfs& vfs_;
+    std::string path_;
+    unsigned long long generation_;
+};
+
+} // namespace
+
+unsigned long long SyntheticTreeSpec::EntryCount() const {
+    unsigned long long dirs = 0, level = 1;
+    for (int i = 0; i < depth; ++i) {
+        level *= dirs_per_dir;
+        dirs += level;
+    }
+    return dirs + (dirs + 1) * files_per_dir;
+}
+
+MemoryVfs::MemoryVfs() : root_(std::make_unique<Node>()) {
+    root_->inode = 1;
+}
+
+MemoryVfs::~MemoryVfs() = default;
+
+bool MemoryVfs::Resolve(const std::string& path, Resolved& out, bool follow_last) {
+    out = Resolved();
+    std::vector<std::string> parts = SplitPath(path);
+    Node* node = root_.get();
+    size_t i = 0;
+    int links = 0;
+    while (i < parts.size() && !node->synthetic) {
+        if (!node->is_dir) return false;
+        auto it = node->children.find(parts[i]);
+        if (it == node->children.end()) return false;
+        Node* child = it->second.get();
+        if (!child->link_target.empty() && (i + 1 < parts.size() || follow_last)) {
+            // Start over with the target in place of the link; too many links means a loop (ELOOP)
+            if (++links > kMaxLinks) return false;
+            std::vector<std::string> rest = SplitPath(child->link_target);
+            rest.insert(rest.end(), parts.begin() + i + 1, parts.end());
+            parts = std::move(rest);
+            node = root_.get();
+            out.device = kDevice;
+            i = 0;
+            continue;
+        }
+        node = child;
+        if (node->device) out.device = node->device;
+        ++i;
+    }
+    out.node = node;
+    out.is_dir = node->is_dir;
+    if (!node->synthetic) return true;
+
+    out.generated = i < parts.size();
+    out.spec = *node->synthetic;
+    out.hash = SyntheticRootHash(out.spec, node->inode);
+    for (; i < parts.size(); ++i) {
+        unsigned index = 0;
+        size_t end = 0;
+        if (ParseIndex(parts[i], 'd', false, index, end)) {
+            if (out.level >= out.spec.depth || index >= out.spec.dirs_per_dir) return false;
+            out.hash = ChildDirHash(out.hash, index);
+            out.level++;
+            continue;
+        }
+        // A file, which must be the last component and carry its generated extension
+        if (i + 1 != parts.size() || !ParseIndex(parts[i], 'f', true, index, end) ||
+            index >= out.spec.files_per_dir) {
+            return false;
+        }
+        unsigned long long hash = FileHash(out.hash, index);
+        if (end == parts[i].size() || parts[i].compare(end + 1, std::string::npos, kSyntheticExtensions[hash % 8]) != 0) {
+            return false;
+        }
+        out.hash = hash;
+        out.is_dir = false;
+        out.file_index = index;
+    }
+    return true;
+}
+
+MemoryVfs::Node* MemoryVfs::MakeDirectories(const std::string& path, bool include_last) {
+    std::vector<std::string> parts = SplitPath(path);
+    if (!include_last) {
+        if (parts.empty()) return nullptr;
+        parts.pop_back();
+    }
+    Node* node = root_.get();
+    for (const std::string& part : parts) {
+        if (!node->is_dir || node->synthetic) return nullptr;
+        std::unique_ptr<Node>& child = node->children[part];
+        if (!child) {
+            child = std::make_unique<Node>();
+            child->inode = next_inode_++;
+            node->generation++;
+        }
+        node = child.get();
+    }
+    return (node->is_dir && !node->synthetic) ? node : nullptr;
+}
+
+bool MemoryVfs::AddDirectory(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return MakeDirectories(path, true) != nullptr;
+}
+
+bool MemoryVfs::AddFile(const std::string& path, unsigned long long size, unsigned long long allocated) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Node* parent = MakeDirectories(path, false);
+    std::vector<std::string> parts = SplitPath(path);
+    if (!parent || parts.empty() || parent->children.count(parts.back())) return false;
+    auto node = std::make_unique<Node>();
+    node->is_dir = false;
+    node->file = std::make_shared<Node::FileData>();
+    node->file->size = size;
+    node->file->allocated = allocated;
+    node->file->inode = next_inode_++;
+    parent->children[parts.back()] = std::move(node);
+    parent->generation++;
+    return true;
+}
+
+bool MemoryVfs::AddHardLink(const std::string& existing, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved target;
+    if (!Resolve(existing, target) || target.generated || target.is_dir) return false;
+    Node* parent = MakeDirectories(path, false);
+    std::vector<std::string> parts = SplitPath(path);
+    if (!parent || parts.empty() || parent->children.count(parts.back())) return false;
+    auto node = std::make_unique<Node>();
+    node->is_dir = false;
+    node->file = target.node->file;
+    node->file->links++;
+    parent->children[parts.back()] = std::move(node);
+    parent->generation++;
+    return true;
+}
+
+bool MemoryVfs::AddSymlink(const std::string& path, const std::string& target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Node* parent = MakeDirectories(path, false);
+    std::vector<std::string> parts = SplitPath(path);
+    if (!parent || parts.empty() || target.empty() || parent->children.count(parts.back())) return false;
+    auto node = std::make_unique<Node>();
+    node->is_dir = false;
+    node->inode = next_inode_++;
+    node->link_target = target;
+    parent->children[parts.back()] = std::move(node);
+    parent->generation++;
+    return true;
+}
+
+bool MemoryVfs::SetDevice(const std::string& path, unsigned long long device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved resolved;
+    if (!Resolve(path, resolved) || resolved.generated || !resolved.is_dir) return false;
+    resolved.node->device = device;
+    return true;
+}
+
+bool MemoryVfs::Remove(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> parts = SplitPath(path);
+    if (parts.empty()) return false;
+    std::string parent_path;
+    for (size_t i = 0; i + 1 < parts.size(); ++i) parent_path += "/" + parts[i];
+    Resolved parent;
+    if (!Resolve(parent_path, parent) || parent.generated || !parent.is_dir || parent.node->synthetic) return false;
+    auto it = parent.node->children.find(parts.back());
+    if (it == parent.node->children.end()) return false;
+    if (it->second->file) it->second->file->links--;
+    parent.node->children.erase(it);
+    parent.node->generation++;
+    return true;
+}
+
+bool MemoryVfs::MountSynthetic(const std::string& path, const SyntheticTreeSpec& spec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Node* node = MakeDirectories(path, true);
+    if (!node) return false;
+    node->children.clear();
+    node->synthetic = std::make_unique<SyntheticTreeSpec>(spec);
+    node->generation++;
+    return true;
+}
+
+unsigned MemoryVfs::EnumeratedFields() const {
+    return kVfsSize | kVfsAllocated | kVfsFileIds | kVfsDirIds | kVfsTimes | kVfsAttributes;
+}
+
+void MemoryVfs::SetLatency(std::chrono::microseconds latency) {
+    latency_us_ = (long long)latency.count();
+}
+
+void MemoryVfs::SetErrorRate(double rate) {
+    rate = std::min(std::max(rate, 0.0), 1.0);
+    error_threshold_ = (unsigned)(rate * (1 << 20));
+}
+
+void MemoryVfs::FailPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key = path;
+    while (key.size() > 1 && key.back() == '/') key.pop_back();
+    failed_paths_.insert(key);
+}
+
+void MemoryVfs::FailEnumeration(const std::string& path, size_t after_entries, int error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key = path;
+    while (key.size() > 1 && key.back() == '/') key.pop_back();
+    failed_enumerations_[key] = { after_entries, error };
+}
+
+unsigned long long MemoryVfs::Generation(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved resolved;
+    if (!Resolve(path, resolved) || resolved.generated) return 0;
+    return resolved.node->generation;
+}
+
+bool MemoryVfs::InjectFailure(const std::string& path) {
+    unsigned threshold = error_threshold_;
+    std::string key = path;
+    while (key.size() > 1 && key.back() == '/') key.pop_back();
+    if (threshold && (HashPath(key) & ((1 << 20) - 1)) < threshold) return true;
+    return !failed_paths_.empty() && failed_paths_.count(key) != 0;
+}
+
+void MemoryVfs::Delay() const {
+    Sleep(latency_us_);
+}
+
+std::unique_ptr<VfsDirectory> MemoryVfs::OpenDirectory(const std::string& path, unsigned) {
+    Delay();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved resolved;
+    if (!Resolve(path, resolved) || !resolved.is_dir || InjectFailure(path)) return nullptr;
+    std::unique_ptr<VfsDirectory> dir;
+    if (resolved.node->synthetic) {
+        dir = std::make_unique<SyntheticDirectory>(resolved.spec, resolved.level, resolved.hash, resolved.device,
+                                                   latency_us_);
+    } else {
+        std::vector<VfsEntry> entries;
+        entries.reserve(resolved.node->children.size());
+        for (const auto& child : resolved.node->children) {
+            VfsEntry entry;
+            FillNode(*child.second, resolved.device, entry);
+            entry.name = child.first;
+            entries.push_back(std::move(entry));
+        }
+        dir = std::make_unique<ListedDirectory>(std::move(entries), latency_us_);
+    }
+    if (!failed_enumerations_.empty()) {
+        std::string key = path;
+        while (key.size() > 1 && key.back() == '/') key.pop_back();
+        auto failure = failed_enumerations_.find(key);
+        if (failure != failed_enumerations_.end()) {
+            return std::make_unique<FailingDirectory>(std::move(dir), failure->second.first, failure->second.second);
+        }
+    }
+    return dir;
+}
+
+bool MemoryVfs::Stat(const std::string& path, VfsEntry& entry, unsigned, bool follow_links) {
+    Delay();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved resolved;
+    if (!Resolve(path, resolved, follow_links) || InjectFailure(path)) return false;
+    entry = VfsEntry();
+    std::vector<std::string> parts = SplitPath(path);
+    if (resolved.generated) {
+        if (resolved.is_dir) {
+            FillSyntheticDirectory(resolved.hash, 0, resolved.device, entry);
+        } else {
+            FillSyntheticFile(resolved.spec, resolved.hash, resolved.file_index, resolved.device, entry);
+        }
+        entry.name = parts.back();
+        return true;
+    }
+    FillNode(*resolved.node, resolved.device, entry);
+    entry.name = parts.empty() ? "/" : parts.back();
+    return true;
+}
+
+std::unique_ptr<VfsFile> MemoryVfs::OpenFile(const std::string& path) {
+    Delay();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolved resolved;
+    if (!Resolve(path, resolved) || resolved.is_dir || InjectFailure(path)) return nullptr;
+    if (resolved.generated) {
+        VfsEntry entry;
+        FillSyntheticFile(resolved.spec, resolved.hash, resolved.file_index, resolved.device, entry);
+        return std::make_unique<MemoryFile>(entry.size, resolved.hash);
+    }
+    return std::make_unique<MemoryFile>(resolved.node->file->size, resolved.node->file->inode);
+}
+
+std::unique_ptr<VfsWatch> MemoryVfs::Watch(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Resolved resolved;
+        if (!Resolve(path, resolved) || !resolved.is_dir) return nullptr;
+    }
+    return std::make_unique<MemoryWatch>(*this, path);
+}
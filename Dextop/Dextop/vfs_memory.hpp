@@ -0,0 +1,92 @@
+#ifndef VFS_MEMORY_HPP
+#define VFS_MEMORY_HPP
+
+#include "vfs.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+// Shape of a generated tree. Nothing is stored per entry: names, sizes and
+// inodes are derived from the path, so trees of tens of millions of entries
+// cost no memory and enumerate identically on every run.
+struct SyntheticTreeSpec {
+    int depth = 4;                           // levels of subfolders below the mount point
+    unsigned dirs_per_dir = 10;
+    unsigned files_per_dir = 10;
+    unsigned long long max_file_size = 1 << 20;
+    unsigned long long seed = 1;
+
+    // Entries (files and folders) below the mount point
+    unsigned long long EntryCount() const;
+};
+
+// In-memory filesystem for benchmarks and reproducible runs. Paths are absolute
+// and '/' separated ("/" is the root). Explicit directories and files can be
+// added, and generated trees mounted on any directory. Latency and I/O errors
+// can be injected to model slow or failing storage. Thread-safe; watches must
+// not outlive the MemoryVfs that created them.
+class MemoryVfs : public Vfs {
+public:
+    MemoryVfs();
+    ~MemoryVfs() override;
+
+    // Parents are created as needed. False if a parent is a file or generated.
+    bool AddDirectory(const std::string& path);
+    bool AddFile(const std::string& path, unsigned long long size, unsigned long long allocated);
+    // A second name for an existing file, sharing its inode
+    bool AddHardLink(const std::string& existing, const std::string& path);
+    // A symlink to the absolute path target, which need not exist
+    bool AddSymlink(const std::string& path, const std::string& target);
+    // Makes the explicit directory at path the root of another filesystem:
+    // it and everything below it report device (1 for the rest)
+    bool SetDevice(const std::string& path, unsigned long long device);
+    bool Remove(const std::string& path);
+    // Replaces the contents of directory path with a generated tree
+    bool MountSynthetic(const std::string& path, const SyntheticTreeSpec& spec);
+
+    // Delay added to every directory open, batch, stat and file open. A directory
+    // keeps the latency set when it was opened.
+    void SetLatency(std::chrono::microseconds latency);
+    // Fraction of directories and files whose open fails, picked by a hash of the
+    // path so the same entries fail on every run
+    void SetErrorRate(double rate);
+    // Opening or stat-ing exactly this path fails
+    void FailPath(const std::string& path);
+    // Directory path opens, but its enumeration stops with error after
+    // returning after_entries entries, like a read error partway through
+    void FailEnumeration(const std::string& path, size_t after_entries, int error = EIO);
+
+    char Separator() const override { return '/'; }
+    unsigned EnumeratedFields() const override;
+    std::unique_ptr<VfsDirectory> OpenDirectory(const std::string& path, unsigned fields) override;
+    bool Stat(const std::string& path, VfsEntry& entry, unsigned fields, bool follow_links = true) override;
+    std::unique_ptr<VfsFile> OpenFile(const std::string& path) override;
+    std::unique_ptr<VfsWatch> Watch(const std::string& path) override;
+
+    // Number of changes made to the explicit directory at path (0 if missing or generated)
+    unsigned long long Generation(const std::string& path);
+
+    struct Node;
+    struct Resolved;
+
+private:
+    // Follows symlinks on the way, and the last component too when follow_last is set
+    bool Resolve(const std::string& path, Resolved& out, bool follow_last = true);
+    Node* MakeDirectories(const std::string& path, bool include_last);
+    bool InjectFailure(const std::string& path);
+    void Delay() const;
+
+    std::mutex mutex_;
+    std::unique_ptr<Node> root_;
+    std::set<std::string> failed_paths_;
+    std::map<std::string, std::pair<size_t, int>> failed_enumerations_; // path -> entries before the error, error
+    unsigned long long next_inode_ = 2;
+    std::atomic<long long> latency_us_{0};
+    std::atomic<unsigned> error_threshold_{0}; // out of 1 << 20
+};
+
+#endif // VFS_MEMORY_HPP
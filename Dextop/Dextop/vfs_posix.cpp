@@ -0,0 +1,180 @@
+// POSIX backend of the VFS layer (Linux, macOS, BSD)
+#ifndef _WIN32
+
+#include "vfs.hpp"
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+void FillFromStat(const struct stat& st, VfsEntry& entry) {
+    entry.is_dir = S_ISDIR(st.st_mode);
+    if (S_ISLNK(st.st_mode)) entry.is_link = true;
+    entry.size = entry.is_dir ? 0 : (unsigned long long)st.st_size;
+    entry.allocated = entry.is_dir ? 0 : (unsigned long long)st.st_blocks * 512;
+    entry.modified = (long long)st.st_mtime;
+    entry.attributes = (unsigned)st.st_mode;
+    entry.has_id = true;
+    entry.device = (unsigned long long)st.st_dev;
+    entry.inode = (unsigned long long)st.st_ino;
+    entry.links = (unsigned long long)st.st_nlink;
+}
+
+class PosixDirectory : public VfsDirectory {
+public:
+    PosixDirectory(DIR* dir, unsigned fields) : dir_(dir), fields_(fields) {}
+    ~PosixDirectory() override { closedir(dir_); }
+
+    bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) override {
+        batch.resize(max_entries);
+        size_t count = 0;
+        while (count < max_entries) {
+            errno = 0;
+            struct dirent* ent = readdir(dir_);
+            if (!ent) {
+                error_ = errno;
+                break;
+            }
+            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+                continue;
+            VfsEntry& entry = batch[count];
+            entry = VfsEntry();
+            entry.name.assign(ent->d_name);
+            entry.is_dir = (ent->d_type == DT_DIR);
+            entry.is_link = (ent->d_type == DT_LNK);
+            // readdir only gives the name and type; stat when the caller needs more
+            bool need_stat = (ent->d_type == DT_UNKNOWN) ||
+                             (entry.is_dir ? (fields_ & (kVfsDirIds | kVfsTimes | kVfsAttributes)) != 0
+                                           : (fields_ & ~kVfsDirIds) != 0);
+            struct stat st;
+            if (need_stat && fstatat(dirfd(dir_), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                FillFromStat(st, entry);
+            }
+            count++;
+        }
+        batch.resize(count);
+        return count > 0;
+    }
+
+    int Error() const override { return error_; }
+
+private:
+    DIR* dir_;
+    unsigned fields_;
+    int error_ = 0;
+};
+
+class PosixFile : public VfsFile {
+public:
+    explicit PosixFile(int fd) : fd_(fd) {}
+    ~PosixFile() override { close(fd_); }
+
+    long long Read(void* buffer, size_t size) override {
+        for (;;) {
+            ssize_t n = read(fd_, buffer, size);
+            if (n >= 0) return (long long)n;
+            if (errno != EINTR) return -1;
+        }
+    }
+
+private:
+    int fd_;
+};
+
+#ifdef __linux__
+class InotifyWatch : public VfsWatch {
+public:
+    explicit InotifyWatch(int fd) : fd_(fd) {}
+    ~InotifyWatch() override { close(fd_); }
+
+    bool Changed(std::vector<std::string>& names) override {
+        names.clear();
+        bool changed = false;
+        bool whole = false;
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t size;
+        while ((size = read(fd_, buffer, sizeof(buffer))) > 0) {
+            changed = true;
+            for (ssize_t offset = 0; offset < size;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                offset += sizeof(struct inotify_event) + event->len;
+                // Lost events, or the directory itself changed: the names do not tell the whole story
+                if (event->len == 0 || (event->mask & IN_Q_OVERFLOW) || names.size() >= kMaxNames) whole = true;
+                else if (!whole) names.emplace_back(event->name);
+            }
+        }
+        if (whole) names.clear();
+        return changed;
+    }
+
+private:
+    // Past this many changed names a full re-read is cheaper than per-entry updates
+    static const size_t kMaxNames = 1024;
+
+    int fd_;
+};
+#endif
+
+class PosixVfs : public Vfs {
+public:
+    char Separator() const override { return '/'; }
+
+    std::unique_ptr<VfsDirectory> OpenDirectory(const std::string& path, unsigned fields) override {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return nullptr;
+        return std::make_unique<PosixDirectory>(dir, fields);
+    }
+
+    bool Stat(const std::string& path, VfsEntry& entry, unsigned, bool follow_links) override {
+        // lstat("link/") would resolve the link, so drop the trailing separator
+        std::string target = path;
+        while (target.size() > 1 && target.back() == '/') target.pop_back();
+        struct stat st;
+        if ((follow_links ? stat(target.c_str(), &st) : lstat(target.c_str(), &st)) != 0) return false;
+        entry = VfsEntry();
+        size_t slash = target.find_last_of('/');
+        entry.name = (slash == std::string::npos) ? target : target.substr(slash + 1);
+        FillFromStat(st, entry);
+        return true;
+    }
+
+    std::unique_ptr<VfsFile> OpenFile(const std::string& path) override {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        return std::make_unique<PosixFile>(fd);
+    }
+
+    std::unique_ptr<VfsWatch> Watch(const std::string& path) override {
+#ifdef __linux__
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return nullptr;
+        // IN_CLOSE_WRITE rather than IN_MODIFY: one event per finished write, not one per write() call
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB |
+                              IN_DELETE_SELF | IN_MOVE_SELF;
+        if (inotify_add_watch(fd, path.c_str(), mask) < 0) {
+            close(fd);
+            return nullptr;
+        }
+        return std::make_unique<InotifyWatch>(fd);
+#else
+        (void)path;
+        return nullptr;
+#endif
+    }
+};
+
+} // namespace
+
+Vfs& NativeVfs() {
+    static PosixVfs vfs;
+    return vfs;
+}
+
+#endif // !_WIN32
@@ -0,0 +1,232 @@
+// Win32 backend of the VFS layer. Paths are UTF-8 at the interface and are
+// converted to UTF-16 with the \\?\ prefix, so they are not limited to MAX_PATH
+// and names outside the ANSI code page survive.
+#ifdef _WIN32
+
+#include "vfs.hpp"
+#include <windows.h>
+
+namespace {
+
+std::wstring Widen(const std::string& text) {
+    if (text.empty()) return std::wstring();
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &wide[0], length);
+    return wide;
+}
+
+std::string Narrow(const wchar_t* text) {
+    int length = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (length <= 1) return std::string();
+    std::string narrow(length - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, &narrow[0], length, nullptr, nullptr);
+    return narrow;
+}
+
+// "C:\dir\" -> "\\?\C:\dir\", "\\server\share\" -> "\\?\UNC\server\share\"
+std::wstring LongPath(const std::string& path) {
+    std::wstring wide = Widen(path);
+    for (wchar_t& c : wide) {
+        if (c == L'/') c = L'\\';
+    }
+    if (wide.compare(0, 4, L"\\\\?\\") == 0) return wide;
+    if (wide.size() >= 2 && wide[0] == L'\\' && wide[1] == L'\\') return L"\\\\?\\UNC\\" + wide.substr(2);
+    if (wide.size() >= 3 && wide[1] == L':' && wide[2] == L'\\') return L"\\\\?\\" + wide;
+    return wide; // relative paths cannot take the prefix
+}
+
+long long FileTimeToUnix(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    if (value.QuadPart < 116444736000000000ULL) return 0;
+    return (long long)((value.QuadPart - 116444736000000000ULL) / 10000000ULL);
+}
+
+// Only symlinks and junctions are links; other reparse points (cloud placeholders,
+// dedup stubs) are ordinary files and directories
+bool IsLinkReparse(DWORD attributes, DWORD tag) {
+    return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+           (tag == IO_REPARSE_TAG_SYMLINK || tag == IO_REPARSE_TAG_MOUNT_POINT);
+}
+
+unsigned long long AllocatedSize(const std::wstring& path) {
+    DWORD high = 0;
+    DWORD low = GetCompressedFileSizeW(path.c_str(), &high);
+    if (low == INVALID_FILE_SIZE && GetLastError() != NO_ERROR) return 0;
+    return ((unsigned long long)high << 32) | low;
+}
+
+bool FillIds(const std::wstring& path, bool follow_links, VfsEntry& entry) {
+    DWORD flags = FILE_FLAG_BACKUP_SEMANTICS | (follow_links ? 0 : FILE_FLAG_OPEN_REPARSE_POINT);
+    HANDLE handle = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, flags, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!ok) return false;
+    entry.has_id = true;
+    entry.device = info.dwVolumeSerialNumber;
+    entry.inode = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    entry.links = info.nNumberOfLinks;
+    return true;
+}
+
+class Win32Directory : public VfsDirectory {
+public:
+    Win32Directory(HANDLE find, const WIN32_FIND_DATAW& first, std::wstring directory, unsigned fields)
+        : find_(find), data_(first), directory_(std::move(directory)), fields_(fields) {}
+    ~Win32Directory() override { FindClose(find_); }
+
+    bool NextBatch(std::vector<VfsEntry>& batch, size_t max_entries) override {
+        batch.resize(max_entries);
+        size_t count = 0;
+        while (count < max_entries && has_data_) {
+            if (wcscmp(data_.cFileName, L".") != 0 && wcscmp(data_.cFileName, L"..") != 0) {
+                VfsEntry& entry = batch[count++];
+                entry = VfsEntry();
+                entry.name = Narrow(data_.cFileName);
+                entry.is_dir = (data_.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                entry.is_link = IsLinkReparse(data_.dwFileAttributes, data_.dwReserved0);
+                entry.attributes = data_.dwFileAttributes;
+                entry.modified = FileTimeToUnix(data_.ftLastWriteTime);
+                if (!entry.is_dir) {
+                    entry.size = ((unsigned long long)data_.nFileSizeHigh << 32) | data_.nFileSizeLow;
+                    entry.allocated = entry.size;
+                }
+                bool want_ids = (fields_ & (entry.is_dir ? kVfsDirIds : kVfsFileIds)) != 0;
+                bool want_allocated = !entry.is_dir && (fields_ & kVfsAllocated);
+                if (want_ids || want_allocated) {
+                    std::wstring full = directory_ + data_.cFileName;
+                    if (want_allocated) entry.allocated = AllocatedSize(full);
+                    if (want_ids) FillIds(full, false, entry);
+                }
+            }
+            if (!FindNextFileW(find_, &data_)) {
+                has_data_ = false;
+                DWORD error = GetLastError();
+                if (error != ERROR_NO_MORE_FILES) error_ = (int)error;
+            }
+        }
+        batch.resize(count);
+        return count > 0;
+    }
+
+    int Error() const override { return error_; }
+
+private:
+    HANDLE find_;
+    WIN32_FIND_DATAW data_;
+    std::wstring directory_;
+    unsigned fields_;
+    bool has_data_ = true;
+    int error_ = 0;
+};
+
+class Win32File : public VfsFile {
+public:
+    explicit Win32File(HANDLE handle) : handle_(handle) {}
+    ~Win32File() override { CloseHandle(handle_); }
+
+    long long Read(void* buffer, size_t size) override {
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD read = 0;
+        if (!ReadFile(handle_, buffer, chunk, &read, nullptr)) return -1;
+        return (long long)read;
+    }
+
+private:
+    HANDLE handle_;
+};
+
+class Win32Watch : public VfsWatch {
+public:
+    explicit Win32Watch(HANDLE handle) : handle_(handle) {}
+    ~Win32Watch() override { FindCloseChangeNotification(handle_); }
+
+    bool Changed(std::vector<std::string>& names) override {
+        names.clear(); // change notifications carry no names
+        if (WaitForSingleObject(handle_, 0) != WAIT_OBJECT_0) return false;
+        FindNextChangeNotification(handle_);
+        return true;
+    }
+
+private:
+    HANDLE handle_;
+};
+
+class Win32Vfs : public Vfs {
+public:
+    char Separator() const override { return '\\'; }
+
+    // FindFirstFileExW returns these with every name
+    unsigned EnumeratedFields() const override { return kVfsSize | kVfsTimes | kVfsAttributes; }
+
+    std::unique_ptr<VfsDirectory> OpenDirectory(const std::string& path, unsigned fields) override {
+        std::wstring directory = LongPath(path);
+        if (!directory.empty() && directory.back() != L'\\') directory += L'\\';
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileExW((directory + L"*").c_str(), FindExInfoBasic, &data,
+                                       FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE) return nullptr;
+        return std::make_unique<Win32Directory>(find, data, std::move(directory), fields);
+    }
+
+    bool Stat(const std::string& path, VfsEntry& entry, unsigned fields, bool follow_links) override {
+        std::wstring target = LongPath(path);
+        // Keep the separator of a drive root ("\\?\C:\"), drop it elsewhere
+        while (target.size() > 7 && target.back() == L'\\') target.pop_back();
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(target.c_str(), GetFileExInfoStandard, &data)) return false;
+        entry = VfsEntry();
+        size_t slash = path.find_last_of("\\/", path.size() > 1 ? path.size() - 2 : 0);
+        entry.name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        if (!entry.name.empty() && (entry.name.back() == '\\' || entry.name.back() == '/')) entry.name.pop_back();
+        entry.is_dir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.attributes = data.dwFileAttributes;
+        entry.modified = FileTimeToUnix(data.ftLastWriteTime);
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            WIN32_FIND_DATAW find_data;
+            HANDLE find = FindFirstFileW(target.c_str(), &find_data);
+            if (find != INVALID_HANDLE_VALUE) {
+                entry.is_link = IsLinkReparse(find_data.dwFileAttributes, find_data.dwReserved0);
+                FindClose(find);
+            }
+        }
+        if (!entry.is_dir) {
+            entry.size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+            entry.allocated = (fields & kVfsAllocated) ? AllocatedSize(target) : entry.size;
+        }
+        if (fields & (kVfsFileIds | kVfsDirIds)) FillIds(target, follow_links, entry);
+        return true;
+    }
+
+    std::unique_ptr<VfsFile> OpenFile(const std::string& path) override {
+        HANDLE handle = CreateFileW(LongPath(path).c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return nullptr;
+        return std::make_unique<Win32File>(handle);
+    }
+
+    std::unique_ptr<VfsWatch> Watch(const std::string& path) override {
+        const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                             FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                             FILE_NOTIFY_CHANGE_ATTRIBUTES;
+        HANDLE handle = FindFirstChangeNotificationW(LongPath(path).c_str(), FALSE, filter);
+        if (handle == INVALID_HANDLE_VALUE) return nullptr;
+        return std::make_unique<Win32Watch>(handle);
+    }
+};
+
+} // namespace
+
+Vfs& NativeVfs() {
+    static Win32Vfs vfs;
+    return vfs;
+}
+
+#endif // _WIN32
@@ -0,0 +1,274 @@
+#include "volume_service.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <cstring>
+#else
+#include <sys/statvfs.h>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+
+// Lists drive letters. GetLogicalDriveStringsA only reads the drive bitmask,
+// so it does not touch (and cannot hang on) the drives themselves.
+std::vector<VolumeInfo> EnumerateMounts() {
+    std::vector<VolumeInfo> mounts;
+    char drives[256];
+    DWORD len = GetLogicalDriveStringsA(sizeof(drives), drives);
+    if (len == 0 || len > sizeof(drives)) return mounts;
+    for (char* drive = drives; *drive; drive += strlen(drive) + 1) {
+        VolumeInfo info;
+        info.root = drive;
+        mounts.push_back(info);
+    }
+    return mounts;
+}
+
+// Queries capacity and filesystem type. May block for a long time on network drives.
+void ProbeVolume(VolumeInfo& info) {
+    ULARGE_INTEGER avail, total, total_free;
+    if (!GetDiskFreeSpaceExA(info.root.c_str(), &avail, &total, &total_free)) {
+        info.state = VolumeState::Error;
+        return;
+    }
+    info.total_bytes = total.QuadPart;
+    info.free_bytes = avail.QuadPart;
+    char label[MAX_PATH + 1] = {};
+    char fs_name[MAX_PATH + 1] = {};
+    if (GetVolumeInformationA(info.root.c_str(), label, sizeof(label), nullptr, nullptr, nullptr, fs_name, sizeof(fs_name))) {
+        info.device = label;
+        info.fs_type = fs_name;
+    }
+    info.state = VolumeState::Ready;
+}
+
+#else
+
+// Decodes the octal escapes (\040 etc.) used for whitespace in mountinfo fields.
+std::string UnescapeMountField(const std::string& field) {
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[i] == '\\' && i + 3 < field.size()) {
+            const char a = field[i + 1], b = field[i + 2], c = field[i + 3];
+            if (a >= '0' && a <= '7' && b >= '0' && b <= '7' && c >= '0' && c <= '7') {
+                out += static_cast<char>((a - '0') * 64 + (b - '0') * 8 + (c - '0'));
+                i += 3;
+                continue;
+            }
+        }
+        out += field[i];
+    }
+    return out;
+}
+
+// Kernel pseudo filesystems that carry no user data. autofs is skipped as
+// well because calling statvfs on it would trigger the automount.
+bool IsPseudoFilesystem(const std::string& fs_type) {
+    static const std::unordered_set<std::string> pseudo = {
+        "proc", "sysfs", "cgroup", "cgroup2", "devpts", "devtmpfs", "mqueue", "debugfs",
+        "tracefs", "securityfs", "pstore", "bpf", "configfs", "fusectl", "hugetlbfs",
+        "autofs", "binfmt_misc", "efivarfs", "rpc_pipefs", "nsfs", "selinuxfs"
+    };
+    return pseudo.count(fs_type) != 0;
+}
+
+// Lists mounts from /proc/self/mountinfo. Reading procfs never blocks on the
+// mounted filesystems themselves.
+std::vector<VolumeInfo> EnumerateMounts() {
+    std::vector<VolumeInfo> mounts;
+    std::ifstream in("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        // id parent major:minor root mount_point options [optional...] - fs_type source super_options
+        std::istringstream fields(line);
+        std::string id, parent, dev, root, mount_point, options, token;
+        if (!(fields >> id >> parent >> dev >> root >> mount_point >> options)) continue;
+        while (fields >> token && token != "-") {}
+        std::string fs_type, source;
+        if (!(fields >> fs_type >> source)) continue;
+        if (IsPseudoFilesystem(fs_type)) continue;
+        VolumeInfo info;
+        info.root = UnescapeMountField(mount_point);
+        if (info.root.empty() || info.root.back() != '/') info.root += '/';
+        info.device = UnescapeMountField(source);
+        info.fs_type = fs_type;
+        // A later line for the same mount point is an over-mount that hides the earlier one.
+        for (auto it = mounts.begin(); it != mounts.end(); ++it) {
+            if (it->root == info.root) { mounts.erase(it); break; }
+        }
+        mounts.push_back(info);
+    }
+    return mounts;
+}
+
+// Queries capacity. May block indefinitely on a dead NFS/SMB mount.
+void ProbeVolume(VolumeInfo& info) {
+    struct statvfs st;
+    if (statvfs(info.root.c_str(), &st) != 0) {
+        info.state = VolumeState::Error;
+        return;
+    }
+    info.total_bytes = static_cast<unsigned long long>(st.f_blocks) * st.f_frsize;
+    info.free_bytes = static_cast<unsigned long long>(st.f_bavail) * st.f_frsize;
+    info.state = VolumeState::Ready;
+}
+
+#endif
+
+} // namespace
+
+VolumeService::VolumeService(std::chrono::milliseconds probe_timeout, std::chrono::milliseconds refresh_interval)
+    : probe_timeout_(probe_timeout), refresh_interval_(refresh_interval) {}
+
+VolumeService::~VolumeService() {
+    Stop();
+}
+
+void VolumeService::Start() {
+    if (running_) return;
+    running_ = true;
+    thread_ = std::thread(&VolumeService::Run, this);
+}
+
+void VolumeService::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void VolumeService::RequestRefresh() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        refresh_requested_ = true;
+    }
+    wake_cv_.notify_all();
+}
+
+std::vector<VolumeInfo> VolumeService::Snapshot() const {
+    std::lock_guard<std::mutex> lock(volumes_mutex_);
+    return volumes_;
+}
+
+void VolumeService::Run() {
+    while (running_) {
+        std::vector<VolumeInfo> mounts = EnumerateMounts();
+        {
+            // Publish newly appeared mounts right away (as Pending) and keep the
+            // cached figures for known ones until their probe completes.
+            std::lock_guard<std::mutex> lock(volumes_mutex_);
+            std::vector<VolumeInfo> merged;
+            merged.reserve(mounts.size());
+            for (const auto& mount : mounts) {
+                VolumeInfo entry = mount;
+                for (const auto& known : volumes_) {
+                    if (known.root == mount.root) { entry = known; break; }
+                }
+                merged.push_back(entry);
+            }
+            volumes_ = std::move(merged);
+        }
+        ProbeAll(std::move(mounts));
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait_for(lock, refresh_interval_, [this] { return !running_ || refresh_requested_; });
+        refresh_requested_ = false;
+    }
+    StopProbers();
+}
+
+void VolumeService::RunProber(std::shared_ptr<Prober> prober) {
+    std::unique_lock<std::mutex> lock(prober->mutex);
+    for (;;) {
+        prober->cv.wait(lock, [&prober] { return prober->stop || (prober->requested && !prober->done); });
+        if (prober->stop) return;
+        VolumeInfo info = prober->request;
+        lock.unlock();
+        ProbeVolume(info);
+        lock.lock();
+        prober->result = std::move(info);
+        prober->done = true;
+        prober->requested = false;
+        prober->cv.notify_all();
+    }
+}
+
+void VolumeService::StopProbers() {
+    for (auto& item : probers_) {
+        {
+            std::lock_guard<std::mutex> lock(item.second->mutex);
+            item.second->stop = true;
+        }
+        item.second->cv.notify_all();
+    }
+    probers_.clear();
+}
+
+void VolumeService::ProbeAll(std::vector<VolumeInfo> mounts) {
+    // Stop the probers of mounts that went away
+    std::unordered_map<std::string, std::shared_ptr<Prober>> probers;
+    for (const auto& mount : mounts) {
+        auto it = probers_.find(mount.root);
+        if (it == probers_.end()) continue;
+        probers.emplace(it->first, it->second);
+        probers_.erase(it);
+    }
+    StopProbers();
+    probers_ = std::move(probers);
+
+    // Queue every probe first so that several dead mounts cost one timeout, not one each.
+    std::vector<std::shared_ptr<Prober>> queued(mounts.size());
+    for (size_t i = 0; i < mounts.size(); ++i) {
+        std::shared_ptr<Prober>& prober = probers_[mounts[i].root];
+        if (!prober) {
+            prober = std::make_shared<Prober>();
+            std::thread(&VolumeService::RunProber, prober).detach();
+        }
+        {
+            std::lock_guard<std::mutex> lock(prober->mutex);
+            if (prober->requested) continue; // previous probe still hung, leave queued[i] empty
+            prober->request = mounts[i];
+            prober->requested = true;
+            prober->done = false;
+        }
+        prober->cv.notify_all();
+        queued[i] = prober;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + probe_timeout_;
+    for (size_t i = 0; i < mounts.size(); ++i) {
+        const auto& prober = queued[i];
+        if (prober) {
+            std::unique_lock<std::mutex> lock(prober->mutex);
+            if (prober->cv.wait_until(lock, deadline, [&prober] { return prober->done; })) {
+                mounts[i] = prober->result;
+                continue;
+            }
+        }
+        mounts[i].state = VolumeState::Unresponsive;
+    }
+
+    std::lock_guard<std::mutex> lock(volumes_mutex_);
+    for (auto& mount : mounts) {
+        // Keep the last known capacity of a mount that stopped responding.
+        if (mount.state == VolumeState::Unresponsive) {
+            for (const auto& known : volumes_) {
+                if (known.root == mount.root) {
+                    mount.total_bytes = known.total_bytes;
+                    mount.free_bytes = known.free_bytes;
+                    if (mount.fs_type.empty()) mount.fs_type = known.fs_type;
+                    break;
+                }
+            }
+        }
+    }
+    volumes_ = std::move(mounts);
+}
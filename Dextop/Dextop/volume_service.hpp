@@ -0,0 +1,89 @@
+#ifndef VOLUME_SERVICE_HPP
+#define VOLUME_SERVICE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Probe state of a single mount / drive letter.
+enum class VolumeState {
+    Pending,      // enumerated, first probe not finished yet
+    Ready,        // capacity and filesystem type are valid
+    Unresponsive, // last probe did not finish within the timeout
+    Error         // probe finished but the volume could not be queried
+};
+
+// Cached information about one mounted volume.
+struct VolumeInfo {
+    std::string root;      // "C:\\" on Windows, mount point with trailing '/' on Linux
+    std::string device;    // source device (Linux) or volume label (Windows)
+    std::string fs_type;   // "NTFS", "ext4", "nfs4", ...
+    unsigned long long total_bytes = 0;
+    unsigned long long free_bytes = 0;  // free bytes available to the caller
+    VolumeState state = VolumeState::Pending;
+};
+
+// Enumerates mounts on a background thread and probes each one for capacity,
+// free space and filesystem type. Each mount has one prober thread that runs
+// its probes one at a time; a probe that exceeds probe_timeout is abandoned, so
+// a hung network drive or stale NFS/SMB mount is reported as Unresponsive
+// instead of blocking the caller, and no further probe is queued behind it.
+class VolumeService {
+public:
+    explicit VolumeService(std::chrono::milliseconds probe_timeout = std::chrono::milliseconds(2000),
+                           std::chrono::milliseconds refresh_interval = std::chrono::milliseconds(5000));
+    ~VolumeService();
+
+    VolumeService(const VolumeService&) = delete;
+    VolumeService& operator=(const VolumeService&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Wakes the background thread for an immediate re-enumeration.
+    void RequestRefresh();
+
+    // Returns a copy of the latest known volumes. Never touches the filesystem.
+    std::vector<VolumeInfo> Snapshot() const;
+
+private:
+    // Shared between the service and the prober thread of one mount, which
+    // outlives the service if its last probe is hung at shutdown.
+    struct Prober {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool requested = false; // a probe is queued or running
+        bool done = false;      // result holds the outcome of the last request
+        bool stop = false;
+        VolumeInfo request;
+        VolumeInfo result;
+    };
+
+    void Run();
+    void ProbeAll(std::vector<VolumeInfo> mounts);
+    static void RunProber(std::shared_ptr<Prober> prober);
+    void StopProbers();
+
+    std::chrono::milliseconds probe_timeout_;
+    std::chrono::milliseconds refresh_interval_;
+
+    std::thread thread_;
+    std::atomic<bool> running_ = false;
+    bool refresh_requested_ = false;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    mutable std::mutex volumes_mutex_;
+    std::vector<VolumeInfo> volumes_;
+
+    // Prober of each mount, keyed by root. Only the service thread touches the map.
+    std::unordered_map<std::string, std::shared_ptr<Prober>> probers_;
+};
+
+#endif // VOLUME_SERVICE_HPP
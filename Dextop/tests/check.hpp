@@ -0,0 +1,34 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+// Assertions shared by the test executables. Each executable tests one part of
+// the core against MemoryVfs, so it runs the same on every machine and needs no
+// fixtures on disk; ctest runs them and a non-zero exit code is a failure.
+
+#include <cstdio>
+
+inline int& CheckFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Reports a failed condition and carries on, so one run lists every failure
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            CheckFailures()++;                                                                  \
+        }                                                                                       \
+    } while (0)
+
+// Exit code for main
+inline int CheckResult() {
+    if (CheckFailures()) {
+        std::fprintf(stderr, "%d checks failed\n", CheckFailures());
+        return 1;
+    }
+    std::printf("all tests passed\n");
+    return 0;
+}
+
+#endif // CHECK_HPP
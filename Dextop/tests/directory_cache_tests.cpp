@@ -0,0 +1,74 @@
+// DirectoryCache: hit counting, eviction to the budget, and failed folders
+
+#include "check.hpp"
+#include "directory_cache.hpp"
+#include "vfs_memory.hpp"
+#include <memory>
+#include <string>
+
+namespace {
+
+void TestDirectoryCacheEviction() {
+    MemoryVfs vfs;
+    for (int d = 0; d < 8; ++d) {
+        for (int f = 0; f < 50; ++f) vfs.AddFile("/c/d" + std::to_string(d) + "/file" + std::to_string(f), 1, 1);
+    }
+    DirectoryCache cache(vfs);
+
+    std::shared_ptr<DirectoryListing> held = cache.Acquire("/c/d0/");
+    for (int d = 1; d < 8; ++d) {
+        cache.Update();
+        cache.Acquire("/c/d" + std::to_string(d) + "/");
+    }
+    cache.Update();
+    // Every frame re-acquiring the same listing is one use
+    for (int frame = 0; frame < 5; ++frame) {
+        cache.Acquire("/c/d7/");
+        cache.Update();
+    }
+    DirectoryCacheStats stats = cache.Stats();
+    CHECK(stats.misses == 8);
+    CHECK(stats.hits == 0);
+    CHECK(stats.listings == 8);
+    CHECK(stats.referenced == 1);
+    CHECK(stats.evictions == 0);
+
+    // Over budget: unused listings go, the one a view holds and the one drawn last frame stay
+    cache.Acquire("/c/d7/");
+    cache.SetBudget(1);
+    cache.Update();
+    stats = cache.Stats();
+    CHECK(stats.evictions == 6);
+    CHECK(stats.listings == 2);
+    CHECK(held->Rows().size() == 50);
+
+    // A revisit after eviction enumerates again
+    cache.Acquire("/c/d1/");
+    CHECK(cache.Stats().misses == 9);
+}
+
+void TestFailedFolders() {
+    MemoryVfs vfs;
+    vfs.AddFile("/c/ok/file", 1, 1);
+    vfs.AddDirectory("/c/bad/");
+    vfs.FailPath("/c/bad");
+    DirectoryCache cache(vfs);
+
+    // Kept as a negative entry: acquiring it again does not retry right away
+    std::shared_ptr<DirectoryListing> bad = cache.Acquire("/c/bad/");
+    CHECK(bad->Rows().empty());
+    cache.Update();
+    cache.Update();
+    CHECK(cache.Acquire("/c/bad/") == bad);
+    DirectoryCacheStats stats = cache.Stats();
+    CHECK(stats.misses == 1);
+    CHECK(stats.failed == 1);
+}
+
+} // namespace
+
+int main() {
+    TestDirectoryCacheEviction();
+    TestFailedFolders();
+    return CheckResult();
+}
@@ -0,0 +1,124 @@
+// ScanTree accounting: hard links, filesystem boundaries, symlinks, and the
+// InodeSet behind hard-link dedup
+
+#include "check.hpp"
+#include "inode_set.hpp"
+#include "scanner.hpp"
+#include "vfs_memory.hpp"
+#include <string>
+
+namespace {
+
+FolderStats Scan(MemoryVfs& vfs, const std::string& root, ScanOptions options) {
+    options.vfs = &vfs;
+    FolderStats total;
+    CHECK(ScanTree(root, options, total));
+    return total;
+}
+
+void TestHardLinks() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/a/data", 1000, 1024);
+    vfs.AddHardLink("/t/a/data", "/t/b/data");
+    vfs.AddHardLink("/t/a/data", "/t/b/c/data");
+    vfs.AddFile("/t/b/own", 10, 10);
+
+    FolderStats plain = Scan(vfs, "/t/", ScanOptions());
+    CHECK(plain.size == 3010);
+    CHECK(plain.files == 4);
+
+    ScanOptions options;
+    options.dedup_hard_links = true;
+    FolderStats dedup = Scan(vfs, "/t/", options);
+    CHECK(dedup.size == 1010);
+    CHECK(dedup.files == 2);
+    CHECK(dedup.hard_links == 2);
+
+    // A set shared between two scans counts the file once across both
+    InodeSet shared;
+    options.shared_inodes = &shared;
+    FolderStats a = Scan(vfs, "/t/a/", options);
+    FolderStats b = Scan(vfs, "/t/b/", options);
+    CHECK(a.size + b.size == 1010);
+}
+
+void TestOneFileSystem() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/local", 100, 100);
+    vfs.AddFile("/t/mnt/remote", 5000, 5000);
+    vfs.AddFile("/t/mnt/sub/remote", 5000, 5000);
+    CHECK(vfs.SetDevice("/t/mnt", 2));
+
+    FolderStats all = Scan(vfs, "/t/", ScanOptions());
+    CHECK(all.size == 10100);
+
+    ScanOptions options;
+    options.one_file_system = true;
+    FolderStats local = Scan(vfs, "/t/", options);
+    CHECK(local.size == 100);
+    CHECK(local.files == 1);
+    CHECK(local.skipped == 1);
+
+    // Scanning the other filesystem itself
+    FolderStats remote = Scan(vfs, "/t/mnt/", options);
+    CHECK(remote.size == 10000);
+}
+
+void TestSymlinks() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/a/file", 10, 10);
+    vfs.AddFile("/t/b/file", 20, 20);
+    vfs.AddSymlink("/t/a/up", "/t");         // back to the root
+    vfs.AddSymlink("/t/b/self", "/t/b");     // to its own folder
+    vfs.AddSymlink("/t/a/to_b", "/t/b");     // a second way into b
+    vfs.AddSymlink("/t/a/to_file", "/t/b/file");
+    vfs.AddSymlink("/t/c/ping", "/t/c/pong");
+    vfs.AddSymlink("/t/c/pong", "/t/c/ping"); // resolves nowhere
+
+    // Not followed, links to folders are skipped; other links count as files
+    // the size of their target path
+    FolderStats plain = Scan(vfs, "/t/", ScanOptions());
+    CHECK(plain.skipped == 3);
+    CHECK(plain.files == 5);
+    CHECK(plain.size == 30 + 9 + 9 + 9);
+    CHECK(plain.dirs == 6);
+
+    // Followed, b is walked once (through a/to_b, which comes first) and the
+    // links back into walked folders are skipped; the dangling pair stays files
+    ScanOptions options;
+    options.follow_links = true;
+    FolderStats followed = Scan(vfs, "/t/", options);
+    CHECK(followed.skipped == 3);
+    CHECK(followed.files == 5);
+    CHECK(followed.size == 30 + 20 + 9 + 9);
+}
+
+void TestInodeSet() {
+    // Enough keys to grow every shard several times
+    const unsigned long long kKeys = 200000;
+    InodeSet set;
+    for (unsigned long long i = 0; i < kKeys; ++i) CHECK(set.Insert(1 + i % 3, i * 7919));
+    CHECK(set.Size() == kKeys);
+    size_t again = 0;
+    for (unsigned long long i = 0; i < kKeys; ++i) again += set.Insert(1 + i % 3, i * 7919);
+    CHECK(again == 0);
+    CHECK(set.Size() == kKeys);
+    // Same inode on another device is another file, and {0, 0} is a key like any other
+    CHECK(set.Insert(4, 0));
+    CHECK(set.Insert(0, 0));
+    CHECK(!set.Insert(0, 0));
+
+    set.Clear();
+    CHECK(set.Size() == 0);
+    CHECK(set.Insert(1, 0));
+}
+
+} // namespace
+
+int main() {
+    TestHardLinks();
+    TestOneFileSystem();
+    TestSymlinks();
+    TestInodeSet();
+    return CheckResult();
+}
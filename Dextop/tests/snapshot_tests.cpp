@@ -0,0 +1,128 @@
+// Snapshot files: writing and reading records back, and the streaming diff
+
+#include "check.hpp"
+#include "snapshot.hpp"
+#include "vfs_memory.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string TempPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void TestSnapshotRoundTrip() {
+    const std::string path = TempPath("dextop_tests_records.snap");
+    std::vector<SnapshotRecord> records(4);
+    records[0] = {"", 10, 16, 1};
+    records[1] = {"a", 0, 0, 0};
+    records[2] = {"a/b", 1ULL << 40, 1ULL << 40, 123456};
+    records[3] = {"ab", 7, 8, 2};
+
+    SnapshotWriter writer;
+    CHECK(writer.Open(path, "/root/"));
+    for (const auto& record : records) writer.Add(record);
+    CHECK(writer.Close());
+
+    SnapshotReader reader;
+    CHECK(reader.Open(path));
+    CHECK(reader.Root() == "/root/");
+    SnapshotRecord record;
+    size_t count = 0;
+    while (reader.Next(record)) {
+        if (count < records.size()) {
+            CHECK(record.path == records[count].path);
+            CHECK(record.bytes == records[count].bytes);
+            CHECK(record.allocated == records[count].allocated);
+            CHECK(record.files == records[count].files);
+        }
+        count++;
+    }
+    CHECK(count == records.size());
+    CHECK(!reader.Corrupt());
+    std::filesystem::remove(path);
+}
+
+void TestSnapshotDiff() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/keep/file", 100, 100);
+    vfs.AddFile("/t/shrink/big", 5000, 5000);
+    vfs.AddFile("/t/shrink/small", 10, 10);
+    vfs.AddDirectory("/t/gone/");
+    vfs.AddFile("/t/gone/file", 300, 300);
+    ScanOptions options;
+    options.vfs = &vfs;
+
+    const std::string before = TempPath("dextop_tests_before.snap");
+    const std::string after = TempPath("dextop_tests_after.snap");
+    FolderStats total;
+    std::string error;
+    CHECK(WriteSnapshot("/t/", options, before, total, error));
+    CHECK(total.size == 5410);
+
+    // A snapshot compared with itself has nothing to rank
+    std::vector<SnapshotDelta> ranked;
+    SnapshotDelta root;
+    CHECK(DiffSnapshots(before, before, DiffOptions(), ranked, root, error));
+    CHECK(ranked.empty());
+    CHECK(!root.Changed());
+
+    vfs.Remove("/t/shrink/big");
+    vfs.Remove("/t/gone");
+    vfs.AddFile("/t/grow/new", 2000, 2000);
+    CHECK(WriteSnapshot("/t/", options, after, total, error));
+
+    CHECK(DiffSnapshots(before, after, DiffOptions(), ranked, root, error));
+    CHECK(root.Growth() == -3300);
+    // Most growth first, shrinking folders last; unchanged folders are left out
+    CHECK(ranked.size() == 4);
+    if (ranked.size() == 4) {
+        CHECK(ranked[0].path == "grow" && !ranked[0].in_old && ranked[0].Growth() == 2000);
+        CHECK(ranked[1].path == "gone" && !ranked[1].in_new && ranked[1].Growth() == -300);
+        CHECK(ranked[2].path == "" && ranked[2].Growth() == -3300);
+        CHECK(ranked[3].path == "shrink" && ranked[3].Growth() == -5000);
+    }
+    for (const auto& delta : ranked) CHECK(delta.path != "keep");
+
+    // --top 1 answers what grew the most
+    DiffOptions top;
+    top.top = 1;
+    CHECK(DiffSnapshots(before, after, top, ranked, root, error));
+    CHECK(ranked.size() == 1 && ranked[0].path == "grow");
+
+    // Ranked by the size of the change, either way
+    DiffOptions by_change;
+    by_change.rank = DiffRank::Change;
+    by_change.max_depth = 1;
+    CHECK(DiffSnapshots(before, after, by_change, ranked, root, error));
+    CHECK(ranked.size() == 4);
+    if (ranked.size() == 4) {
+        CHECK(ranked[0].path == "shrink");
+        CHECK(ranked[1].path == "");
+        CHECK(ranked[2].path == "grow");
+        CHECK(ranked[3].path == "gone");
+    }
+
+    // Snapshots of different roots are not compared unless asked to
+    const std::string other = TempPath("dextop_tests_other.snap");
+    CHECK(WriteSnapshot("/t/keep/", options, other, total, error));
+    CHECK(!DiffSnapshots(before, other, DiffOptions(), ranked, root, error));
+    CHECK(!error.empty());
+    DiffOptions any_root;
+    any_root.any_root = true;
+    CHECK(DiffSnapshots(before, other, any_root, ranked, root, error));
+
+    std::filesystem::remove(before);
+    std::filesystem::remove(after);
+    std::filesystem::remove(other);
+}
+
+} // namespace
+
+int main() {
+    TestSnapshotRoundTrip();
+    TestSnapshotDiff();
+    return CheckResult();
+}
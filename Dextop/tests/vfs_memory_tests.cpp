@@ -0,0 +1,87 @@
+// MemoryVfs: symlink resolution, devices, injected enumeration errors and latency
+
+#include "check.hpp"
+#include "scanner.hpp"
+#include "vfs_memory.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+void TestSymlinks() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/a/file", 10, 10);
+    CHECK(vfs.AddSymlink("/t/a/up", "/t"));
+    CHECK(vfs.AddSymlink("/t/c/ping", "/t/c/pong"));
+    CHECK(vfs.AddSymlink("/t/c/pong", "/t/c/ping")); // resolves nowhere
+    CHECK(!vfs.AddSymlink("/t/a/file/link", "/t"));   // parent is a file
+
+    VfsEntry entry;
+    CHECK(vfs.Stat("/t/a/up/a/file", entry, 0) && entry.size == 10);
+    CHECK(vfs.Stat("/t/a/up", entry, 0) && entry.is_dir && !entry.is_link);
+    CHECK(vfs.Stat("/t/a/up", entry, 0, false) && entry.is_link && entry.size == 2);
+    CHECK(!vfs.Stat("/t/c/ping", entry, 0));
+    CHECK(vfs.Stat("/t/c/ping", entry, 0, false) && entry.is_link);
+    CHECK(vfs.OpenDirectory("/t/a/up/a/", 0) != nullptr);
+}
+
+void TestDevices() {
+    MemoryVfs vfs;
+    vfs.AddFile("/t/local", 1, 1);
+    vfs.AddFile("/t/mnt/sub/remote", 1, 1);
+    CHECK(vfs.SetDevice("/t/mnt", 2));
+    CHECK(!vfs.SetDevice("/t/local", 2));
+
+    VfsEntry entry;
+    CHECK(vfs.Stat("/t/", entry, kVfsDirIds) && entry.device == 1);
+    CHECK(vfs.Stat("/t/mnt/", entry, kVfsDirIds) && entry.device == 2);
+    CHECK(vfs.Stat("/t/mnt/sub/remote", entry, kVfsFileIds) && entry.device == 2);
+}
+
+void TestEnumerationErrors() {
+    MemoryVfs vfs;
+    for (int i = 0; i < 10; ++i) vfs.AddFile("/t/a/f" + std::to_string(i), 1, 1);
+    vfs.AddFile("/t/b", 1, 1);
+    vfs.FailEnumeration("/t/a/", 4);
+
+    std::unique_ptr<VfsDirectory> dir = vfs.OpenDirectory("/t/a/", 0);
+    CHECK(dir != nullptr);
+    std::vector<VfsEntry> batch;
+    size_t entries = 0;
+    while (dir && dir->NextBatch(batch, 3)) entries += batch.size();
+    CHECK(entries == 4);
+    CHECK(dir && dir->Error() == EIO);
+
+    // The scan keeps what it read and counts the folder as an error
+    ScanOptions options;
+    options.vfs = &vfs;
+    FolderStats total;
+    CHECK(ScanTree("/t/", options, total));
+    CHECK(total.files == 5);
+    CHECK(total.errors == 1);
+}
+
+void TestLatency() {
+    MemoryVfs vfs;
+    for (int i = 0; i < 10; ++i) vfs.AddFile("/t/f" + std::to_string(i), 1, 1);
+    vfs.SetLatency(std::chrono::milliseconds(5));
+
+    // Five batches of two and the final empty one, each delayed
+    std::unique_ptr<VfsDirectory> dir = vfs.OpenDirectory("/t/", 0);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<VfsEntry> batch;
+    while (dir && dir->NextBatch(batch, 2)) {}
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+}
+
+} // namespace
+
+int main() {
+    TestSymlinks();
+    TestDevices();
+    TestEnumerationErrors();
+    TestLatency();
+    return CheckResult();
+}